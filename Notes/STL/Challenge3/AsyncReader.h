@@ -0,0 +1,459 @@
+#ifndef CPPNOTES_ASYNCREADER_H
+#define CPPNOTES_ASYNCREADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Tokenizer.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define CPPNOTES_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef CPPNOTES_IO_URING
+
+// The smallest io_uring wrapper that can queue reads and reap their
+// completions, talking to the kernel through the raw syscalls so that liburing
+// is not needed. Converts to false if the kernel (or a seccomp filter) refuses
+// to set up a ring.
+class IoUring {
+private:
+    int ringFd {-1};
+    void* sqRing {MAP_FAILED};
+    void* cqRing {MAP_FAILED};
+    io_uring_sqe* sqes {static_cast<io_uring_sqe*>(MAP_FAILED)};
+    std::size_t sqRingSize {0};
+    std::size_t cqRingSize {0};
+    std::size_t sqesSize {0};
+    unsigned* sqHead {nullptr};
+    unsigned* sqTail {nullptr};
+    unsigned* sqArray {nullptr};
+    unsigned sqMask {0};
+    unsigned sqEntries {0};
+    unsigned* cqHead {nullptr};
+    unsigned* cqTail {nullptr};
+    io_uring_cqe* cqes {nullptr};
+    unsigned cqMask {0};
+    // A submit failed and left its SQE in the ring. Nothing may be submitted
+    // after that, or the kernel would pick the stale SQE up first.
+    bool broken {false};
+
+    template <typename T>
+    static T* at(void* ring, std::uint32_t offset) {
+        return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+    }
+
+    static int enter(int fd, unsigned submit, unsigned wait, unsigned flags) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait, flags, nullptr, 0));
+    }
+
+public:
+    explicit IoUring(unsigned entries) {
+        io_uring_params params {};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0)
+            return;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_SQ_RING);
+        cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                      IORING_OFF_CQ_RING);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                               MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES));
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+            close(ringFd);
+            ringFd = -1;
+            return;
+        }
+
+        sqHead = at<unsigned>(sqRing, params.sq_off.head);
+        sqTail = at<unsigned>(sqRing, params.sq_off.tail);
+        sqArray = at<unsigned>(sqRing, params.sq_off.array);
+        sqMask = *at<unsigned>(sqRing, params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        cqHead = at<unsigned>(cqRing, params.cq_off.head);
+        cqTail = at<unsigned>(cqRing, params.cq_off.tail);
+        cqes = at<io_uring_cqe>(cqRing, params.cq_off.cqes);
+        cqMask = *at<unsigned>(cqRing, params.cq_off.ring_mask);
+    }
+
+    IoUring(const IoUring& other) = delete;
+    IoUring& operator=(const IoUring& rhs) = delete;
+
+    ~IoUring() {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED)
+            munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED)
+            munmap(sqRing, sqRingSize);
+        if (ringFd >= 0)
+            close(ringFd);
+    }
+
+    explicit operator bool() const { return ringFd >= 0; }
+    // Whether a submit has failed, see read()
+    bool isBroken() const { return broken; }
+
+    // Queues a read of length bytes at offset and hands it to the kernel.
+    // The kernel only sees an SQE once the tail is published, so the tail has
+    // to move before io_uring_enter(). If the submit then fails, the SQE is
+    // still sitting in the ring pointing at buffer: the ring is marked broken
+    // and refuses every later read, so that SQE is never submitted and the
+    // caller can safely fill buffer some other way.
+    bool read(int fd, char* buffer, unsigned length, std::uint64_t offset, std::uint64_t tag) {
+        if (broken)
+            return false;
+        unsigned tail {*sqTail};
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+            return false;
+
+        unsigned index {tail & sqMask};
+        io_uring_sqe& sqe {sqes[index]};
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = tag;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        int submitted;
+        while ((submitted = enter(ringFd, 1, 0, 0)) < 0 && errno == EINTR) { }
+        broken = submitted != 1;
+        return !broken;
+    }
+
+    // Blocks until a read completes. result is its byte count or -errno.
+    bool wait(std::uint64_t& tag, int& result) {
+        while (true) {
+            unsigned head {*cqHead};
+            if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe {cqes[head & cqMask]};
+                tag = cqe.user_data;
+                result = cqe.res;
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            if (enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+                return false;
+        }
+    }
+};
+
+#endif
+
+// Reads a file sequentially into a few large buffers that are kept in flight
+// while the caller works on the one before them, so disk (or network) latency
+// and tokenizing overlap instead of taking turns as they do with getline.
+//
+// The reads go through io_uring where the kernel allows it: every free buffer
+// has a read queued on the ring at all times. Otherwise a reader thread fills
+// the buffers with pread() one step ahead of the caller. Either way the caller
+// only ever sees whole lines: the unfinished line at the end of a buffer is
+// carried over and handed out together with the start of the next one.
+class AsyncReader {
+private:
+    struct Slot {
+        std::vector<char> data;
+        std::size_t length {0};
+        bool ready {false};
+        bool failed {false};
+        bool inRing {false};        // an io_uring read into data has not completed yet
+        std::size_t chunk {0};      // the chunk that read is for
+    };
+
+    int fd {-1};
+    std::uint64_t fileSize {0};
+    std::size_t bufferSize;
+    std::vector<Slot> slots;
+    bool allowIoUring;
+    bool ioUring {false};
+
+    std::mutex lock;
+    std::condition_variable changed;
+
+    std::size_t chunkCount() const { return static_cast<std::size_t>((fileSize + bufferSize - 1) / bufferSize); }
+
+    std::size_t chunkLength(std::size_t chunk) const {
+        return static_cast<std::size_t>(std::min<std::uint64_t>(bufferSize, fileSize - chunk * bufferSize));
+    }
+
+    // pread() until length bytes are in, or the file turns out to be shorter
+    std::size_t readFully(char* buffer, std::size_t length, std::uint64_t offset, bool& error) const {
+        std::size_t done {0};
+        while (done < length) {
+            ssize_t got {pread(fd, buffer + done, length - done, static_cast<off_t>(offset + done))};
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0)
+                error = true;
+            if (got <= 0)
+                break;
+            done += static_cast<std::size_t>(got);
+        }
+        return done;
+    }
+
+#ifdef CPPNOTES_IO_URING
+    // Gives up on a buffer the kernel may still write into. It is moved out
+    // of the slot and never freed, so that memory can never be handed out
+    // again while a read is still landing in it. Only happens if reaping
+    // io_uring completions fails, so at most a few buffers are lost that way.
+    static void abandon(std::vector<char>& buffer) {
+        static auto* abandoned = new std::vector<std::vector<char>>;
+        abandoned->push_back(std::move(buffer));
+        buffer = std::vector<char>{};
+    }
+#endif
+
+    // Reader thread: fills chunk k into slot k % slots as soon as the caller
+    // has given that slot back
+    void readAhead(const bool& stop) {
+        for (std::size_t chunk {0}; chunk < chunkCount(); chunk++) {
+            Slot& slot {slots[chunk % slots.size()]};
+            {
+                std::unique_lock<std::mutex> guard {lock};
+                changed.wait(guard, [&]() { return !slot.ready || stop; });
+                if (stop)
+                    return;
+            }
+            bool error {false};
+            std::size_t length {readFully(slot.data.data(), chunkLength(chunk), chunk * bufferSize, error)};
+            {
+                std::lock_guard<std::mutex> guard {lock};
+                slot.length = length;
+                slot.failed = error;
+                slot.ready = true;
+            }
+            changed.notify_all();
+        }
+    }
+
+    // Calls onChunk(text) for each chunk of the file in order, true if all of
+    // them were read in full
+    template <typename OnChunk>
+    bool forEachChunk(OnChunk onChunk) {
+        std::size_t chunks {chunkCount()};
+        bool complete {true};
+        for (auto& slot : slots) {
+            slot.ready = false;
+            slot.failed = false;
+        }
+
+#ifdef CPPNOTES_IO_URING
+        IoUring ring {allowIoUring ? static_cast<unsigned>(slots.size()) : 0};
+        ioUring = allowIoUring && static_cast<bool>(ring);
+        if (ioUring) {
+            std::size_t inFlight {0};
+            bool ringFailed {false};
+            auto queue = [&](std::size_t chunk) {
+                Slot& slot {slots[chunk % slots.size()]};
+                slot.ready = false;
+                slot.failed = false;
+                slot.chunk = chunk;
+                if (!ringFailed && ring.read(fd, slot.data.data(), static_cast<unsigned>(chunkLength(chunk)),
+                                             chunk * bufferSize, chunk)) {
+                    slot.inRing = true;
+                    inFlight++;
+                } else {
+                    // Could not queue it, read it here instead. The ring takes
+                    // no more reads after a failed submit, and later passes go
+                    // through the pread() reader thread.
+                    if (ring.isBroken())
+                        allowIoUring = false;
+                    slot.length = readFully(slot.data.data(), chunkLength(chunk), chunk * bufferSize, slot.failed);
+                    slot.ready = true;
+                }
+            };
+            for (std::size_t chunk {0}; chunk < std::min(chunks, slots.size()); chunk++)
+                queue(chunk);
+
+            for (std::size_t chunk {0}; chunk < chunks && complete; chunk++) {
+                Slot& slot {slots[chunk % slots.size()]};
+                while (!slot.ready) {
+                    std::uint64_t tag;
+                    int result;
+                    if (!ring.wait(tag, result)) {
+                        // Nothing more can be reaped, but the reads the kernel
+                        // already took may still land at any time. Their
+                        // buffers are abandoned and every read still owed,
+                        // this one included, goes into a fresh buffer instead.
+                        ringFailed = true;
+                        allowIoUring = false;
+                        inFlight = 0;
+                        for (auto& stale : slots) {
+                            if (!stale.inRing)
+                                continue;
+                            abandon(stale.data);
+                            stale.data.resize(bufferSize);
+                            stale.inRing = false;
+                            stale.length = readFully(stale.data.data(), chunkLength(stale.chunk),
+                                                     stale.chunk * bufferSize, stale.failed);
+                            stale.ready = true;
+                        }
+                        break;
+                    }
+                    inFlight--;
+                    Slot& done {slots[tag % slots.size()]};
+                    done.inRing = false;
+                    std::size_t want {chunkLength(static_cast<std::size_t>(tag))};
+                    std::uint64_t offset {tag * bufferSize};
+                    if (result < 0) {
+                        // e.g. a kernel without IORING_OP_READ
+                        done.length = readFully(done.data.data(), want, offset, done.failed);
+                    } else {
+                        // Finish short reads synchronously
+                        done.length = static_cast<std::size_t>(result);
+                        if (done.length < want && result > 0)
+                            done.length += readFully(done.data.data() + done.length, want - done.length,
+                                                     offset + done.length, done.failed);
+                    }
+                    done.ready = true;
+                }
+
+                complete = !slot.failed && slot.length == chunkLength(chunk);
+                onChunk(std::string_view{slot.data.data(), slot.length});
+                if (chunk + slots.size() < chunks && complete)
+                    queue(chunk + slots.size());
+            }
+
+            // Reap anything still in flight before the buffers go away. If
+            // that fails, the buffers still owed a read are abandoned too.
+            std::uint64_t tag;
+            int result;
+            while (inFlight > 0 && ring.wait(tag, result)) {
+                slots[tag % slots.size()].inRing = false;
+                inFlight--;
+            }
+            for (auto& stale : slots) {
+                if (!stale.inRing)
+                    continue;
+                abandon(stale.data);
+                stale.data.resize(bufferSize);
+                stale.inRing = false;
+                allowIoUring = false;
+            }
+            return complete;
+        }
+#endif
+
+        bool stop {false};
+        std::thread reader {&AsyncReader::readAhead, this, std::cref(stop)};
+        for (std::size_t chunk {0}; chunk < chunks && complete; chunk++) {
+            Slot& slot {slots[chunk % slots.size()]};
+            {
+                std::unique_lock<std::mutex> guard {lock};
+                changed.wait(guard, [&slot]() { return slot.ready; });
+            }
+            complete = !slot.failed && slot.length == chunkLength(chunk);
+            onChunk(std::string_view{slot.data.data(), slot.length});
+            {
+                std::lock_guard<std::mutex> guard {lock};
+                slot.ready = false;
+            }
+            changed.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> guard {lock};
+            stop = true;
+        }
+        changed.notify_all();
+        reader.join();
+        return complete;
+    }
+
+public:
+    // allowIoUring = false always uses the pread() reader thread
+    explicit AsyncReader(const std::string& path, std::size_t bufferSize = 4 << 20, std::size_t buffers = 3,
+                         bool allowIoUring = true)
+        : bufferSize{std::max<std::size_t>(bufferSize, 4096)}, slots(std::max<std::size_t>(buffers, 2)),
+          allowIoUring{allowIoUring} {
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            fd = -1;
+            return;
+        }
+        fileSize = static_cast<std::uint64_t>(info.st_size);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (auto& slot : slots)
+            slot.data.resize(this->bufferSize);
+    }
+
+    AsyncReader(const AsyncReader& other) = delete;
+    AsyncReader& operator=(const AsyncReader& rhs) = delete;
+
+    ~AsyncReader() {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    explicit operator bool() const { return fd >= 0; }
+
+    // Calls onLines(text) with consecutive runs of whole lines covering the
+    // file in order (only the very last one may lack its '\n'). Returns false
+    // if a read failed or the file shrank while it was being read.
+    template <typename OnLines>
+    bool forEachLines(OnLines onLines) {
+        std::string carry;
+        bool complete {forEachChunk([&](std::string_view chunk) {
+            std::size_t last {chunk.rfind('\n')};
+            if (last == std::string_view::npos) {
+                // A line longer than a whole buffer
+                carry.append(chunk);
+                return;
+            }
+            std::size_t first {0};
+            if (!carry.empty()) {
+                first = chunk.find('\n') + 1;
+                carry.append(chunk.substr(0, first));
+                onLines(std::string_view{carry});
+                carry.clear();
+            }
+            if (first <= last)
+                onLines(chunk.substr(first, last + 1 - first));
+            carry.append(chunk.substr(last + 1));
+        })};
+        if (!carry.empty())
+            onLines(std::string_view{carry});
+        return complete;
+    }
+
+    // forEachWord() over the whole file, with line numbers starting at 1
+    template <typename OnWord>
+    bool forEachWord(OnWord onWord) {
+        int lineCount {1};
+        return forEachLines([&](std::string_view lines) {
+            ::forEachWord(lines, onWord, lineCount);
+            lineCount += static_cast<int>(std::count(lines.begin(), lines.end(), '\n'));
+        });
+    }
+
+    // Whether the last read went through io_uring rather than the reader thread
+    bool usedIoUring() const { return ioUring; }
+};
+
+#endif //CPPNOTES_ASYNCREADER_H
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "MappedFile.h"
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "WordReport.h"
+#include "CorpusGenerator.h"
+#include "ReportWriter.h"
+
+// Times each stage of the Challenge3 pipeline on synthetic corpora:
+// tokenizing, part 1 counting, the part 2 concordance and printing the reports
+// (through std::ostream and through ReportWriter).
+// For every stage it reports corpus MB/s, the peak RSS reached during the stage
+// and the number of heap allocations it made.
+//
+// Counting and the concordance tokenize as they go, the way Challenge3 runs
+// them (keeping every token of a 10 GB corpus around to time them alone would
+// not fit in memory), so their rows are cumulative and labelled "tokenize+".
+// What the counting itself costs is roughly its row minus the tokenize row.
+//
+// Usage: Benchmark [--sizes MB,MB,...] [--seed N] [--vocab N] [--zipf S] [--dir DIR]
+// Defaults: --sizes 1,100,10240 --seed 42 --vocab 100000 --zipf 1.0 --dir /tmp
+// The corpus is streamed to a file in DIR and mapped, so 10 GB runs do not
+// need 10 GB of memory for the text itself. Mapped pages the stage touched
+// count towards its peak RSS.
+
+std::atomic<std::size_t> allocations {0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p {std::malloc(size > 0 ? size : 1)})
+        return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct StageResult {
+    double seconds;
+    long peakRssKb;
+    std::size_t allocations;
+};
+
+void resetPeakRss();
+long peakRssKb();
+template <typename Stage>
+StageResult measure(Stage stage);
+void report(std::size_t megabytes, const std::string& stage, const StageResult& result, std::size_t bytes);
+
+int main(int argc, char* argv[]) {
+    std::vector<std::size_t> sizes {1, 100, 10240};
+    std::uint64_t seed {42};
+    std::size_t vocabulary {100000};
+    double zipf {1.0};
+    std::string dir {"/tmp"};
+
+    for (int i {1}; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--sizes") == 0) {
+            sizes.clear();
+            std::stringstream ss {argv[i + 1]};
+            std::string size;
+            while (getline(ss, size, ','))
+                sizes.push_back(std::stoul(size));
+        } else if (std::strcmp(argv[i], "--seed") == 0)
+            seed = std::stoull(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--vocab") == 0)
+            vocabulary = std::stoul(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--zipf") == 0)
+            zipf = std::stod(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--dir") == 0)
+            dir = argv[i + 1];
+    }
+
+    std::cout << std::setw(10) << std::left << "Size"
+              << std::setw(20) << std::left << "Stage"
+              << std::setw(10) << std::right << "Seconds"
+              << std::setw(10) << std::right << "MB/s"
+              << std::setw(14) << std::right << "Peak RSS MB"
+              << std::setw(14) << std::right << "Allocations" << std::endl;
+    std::cout << std::string(78, '=') << std::endl;
+
+    for (auto megabytes : sizes) {
+        std::string path {dir + "/challenge3_corpus_" + std::to_string(megabytes) + "MB.txt"};
+        {
+            std::ofstream outFile {path, std::ios::binary | std::ios::trunc};
+            CorpusGenerator generator {seed, vocabulary, zipf};
+            generator.write(outFile, megabytes * 1024 * 1024);
+            if (!outFile) {
+                std::cerr << "\nError writing " << path << std::endl;
+                return 1;
+            }
+        }
+
+        MappedFile inFile {path};
+        if (!inFile) {
+            std::cerr << "\nError opening input file!" << std::endl;
+            return 1;
+        }
+        std::string_view text {inFile.view()};
+
+        std::size_t tokens {0};
+        report(megabytes, "tokenize", measure([&]() {
+            forEachWord(text, [&tokens](std::string_view, int) { tokens++; });
+        }), text.size());
+
+        WordCounts counts;
+        report(megabytes, "tokenize+count", measure([&]() {
+            forEachWord(text, [&counts](std::string_view word, int) { addWord(counts, word); });
+        }), text.size());
+
+        WordPostings lines;
+        report(megabytes, "tokenize+concord", measure([&]() {
+            forEachWord(text, [&lines](std::string_view word, int line) { addWord(lines, word, line); });
+        }), text.size());
+
+        std::ofstream devNull {"/dev/null"};
+        report(megabytes, "print", measure([&]() {
+            displayCounts(counts, devNull);
+            displayLines(lines, devNull);
+            devNull.flush();
+        }), text.size());
+
+        int nullFd {open("/dev/null", O_WRONLY)};
+        report(megabytes, "print fast", measure([&]() {
+            ReportWriter writer {nullFd};
+            writer.writeCounts(counts);
+            writer.writeLines(lines);
+        }), text.size());
+        close(nullFd);
+
+        std::remove(path.c_str());
+    }
+    return 0;
+}
+
+// Linux resets VmHWM (peak RSS) when "5" is written to clear_refs. Where that
+// is not possible the peak is simply the peak since the program started.
+void resetPeakRss() {
+    std::ofstream clearRefs {"/proc/self/clear_refs"};
+    if (clearRefs)
+        clearRefs << "5";
+}
+
+long peakRssKb() {
+    std::ifstream status {"/proc/self/status"};
+    std::string line;
+    while (getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stol(line.substr(6));
+
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+template <typename Stage>
+StageResult measure(Stage stage) {
+    resetPeakRss();
+    std::size_t allocationsBefore {allocations.load()};
+    auto start = std::chrono::steady_clock::now();
+    stage();
+    double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    return {seconds, peakRssKb(), allocations.load() - allocationsBefore};
+}
+
+void report(std::size_t megabytes, const std::string& stage, const StageResult& result, std::size_t bytes) {
+    std::cout << std::setw(10) << std::left << (std::to_string(megabytes) + "MB")
+              << std::setw(20) << std::left << stage
+              << std::setw(10) << std::right << std::fixed << std::setprecision(3) << result.seconds
+              << std::setw(10) << std::right << std::setprecision(1)
+              << static_cast<double>(bytes) / (1024 * 1024) / result.seconds
+              << std::setw(14) << std::right << std::setprecision(1) << static_cast<double>(result.peakRssKb) / 1024
+              << std::setw(14) << std::right << result.allocations << std::endl;
+}
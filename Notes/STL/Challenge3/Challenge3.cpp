@@ -9,14 +9,91 @@
 #include <iomanip>
 #include <map>
 #include <set>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "MappedFile.h"
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "ParallelCount.h"
+#include "WordTable.h"
+#include "IndexFile.h"
+#include "FollowIndexer.h"
+#include "FusedBuilder.h"
+#include "TopK.h"
+#include "WordReport.h"
+#include "DirectoryIndexer.h"
+#include "ReportWriter.h"
+#include "PositionalIndex.h"
+#include "VocabularyTrie.h"
+#include "AsyncReader.h"
+#include "HyperLogLog.h"
+#include "StopWords.h"
+#include "WordDictionary.h"
+#include "SpillingCounter.h"
+#include "SegmentStore.h"
+#include "LineIndex.h"
+#include "TrigramIndex.h"
+#include "NGramCounter.h"
 
-void part1();
-void part2();
-void displayWords(const std::map<std::string, int>& words);
-void displayWords(const std::map<std::string, std::set<int>>& words);
+void part1(const std::string& path);
+void part2(const std::string& path);
+void part1Mapped(const std::string& path);
+void part2Mapped(const std::string& path);
+void part1Async(const std::string& path);
+void part2Async(const std::string& path);
+void part1Spilled(const std::string& path, std::size_t budgetBytes, const std::string& tempDir);
+void part1Parallel(const std::string& path, unsigned threads);
+void part1Hashed(const std::string& path);
+void part2Compact(const std::string& path, const std::string& saveIndexPath);
+void lookupWords(const std::string& indexPath, const std::vector<std::string>& lookups);
+void lookupSegments(const std::string& storeDir, const std::vector<std::string>& lookups);
+template <typename Index>
+void displayLookups(const Index& index, const std::vector<std::string>& lookups);
+void addSegment(const std::string& path, const std::string& storeDir);
+void showContext(const std::string& path, const std::string& indexPath, const std::vector<std::string>& lookups,
+                 int context);
+template <typename Hits>
+void displayContext(const std::string& word, const Hits& hits, const LineIndex& lines, int context);
+void mergeSegments(const std::string& storeDir);
+void displaySegments(const SegmentStore& store);
+void followFile(const std::string& path, int intervalMs);
+void partsFused(const std::string& path, bool countsFromLines);
+void partsInterned(const std::string& path);
+void partTopK(const std::string& path, std::size_t k, std::size_t counters);
+void displayWords(const std::vector<SpaceSaving::Entry>& words);
+void partDirectory(const std::string& dir, unsigned threads);
+void displayWords(const MultiFileIndex& index);
+void findPhrases(const std::string& path, const std::vector<std::string>& phrases);
+void completePrefixes(const std::string& path, const std::vector<std::string>& prefixes);
+void countDistinct(const std::vector<std::string>& paths, int precision, unsigned threads);
+void matchWildcards(const std::string& path, const std::vector<std::string>& patterns);
+void partNGrams(const std::string& path, int n, std::size_t k, std::size_t capacity);
+void displayWords(const std::vector<NGramCounter::Entry>& ngrams);
+template <typename Pairs>
+void reportCounts(const Pairs& words);
+template <typename Map>
+void reportLines(const Map& words);
+void displayWords(const WordCounts& words);
+void displayWords(const WordTable& words);
+void displayWords(const WordLines& words);
+void displayWords(const WordPostings& words);
 std::string cleanStr(const std::string& str);
+int finishReports();
 
-int main() {
+const std::string wordsFile {"../Notes/Challenge3/words.txt"};
+// File descriptor the reports go to through a ReportWriter, -1 = std::cout
+int reportFd {-1};
+// Set when a ReportWriter could not write everything out
+bool reportFailed {false};
+// Leave stopwords out of the part 1 / part 2 reports
+bool dropStopWords {false};
+
+int main(int argc, char* argv[]) {
     // /**=================**/
     // ===== Challenge 3 =====
     // /**=================**/
@@ -74,16 +151,317 @@ int main() {
 
     // Use std::map<std::string, std::set<int>>
 
-    part1();
-    part2();
-    return 0;
+    // Usage: Challenge3 [--mmap | --async] [--threads N] [--hash] [--compact]
+    //                   [--save-index FILE] [--index FILE --lookup WORD...]
+    //                   [--follow [--interval MS]] [--fused | --fused-postings | --interned]
+    //                   [--top K [--counters M]] [--dir DIR [--threads N]]
+    //                   [--fast-output | --out FILE] [--phrase "WORDS"...]
+    //                   [--prefix P...] [--distinct P [--threads N] [--dir DIR]]
+    //                   [--stopwords] [--memory-budget MB [--temp-dir DIR]]
+    //                   [--add-segment DIR] [--segments DIR --lookup WORD...]
+    //                   [--merge-segments DIR] [--context N --lookup WORD... [--index FILE]]
+    //                   [--wildcard PATTERN...] [--ngrams N [--top K] [--counters M]] [file]
+    //   --mmap       tokenize straight over a memory mapped copy of the file,
+    //                for corpora too large for the getline/stringstream version.
+    //   --async      tokenize while the next buffers are still being read
+    //                (io_uring, or a pread() thread), for cold or slow disks.
+    //   --threads N  mapped part 1 counted on N threads (0 = one per core).
+    //   --hash       mapped part 1 counted in an open addressing WordTable,
+    //                only sorted once before printing.
+    //   --compact    mapped part 2 with the line sets stored as delta/varint
+    //                PostingLists instead of std::set<int>.
+    //   --save-index FILE  also write the part 2 index to FILE (implies --compact).
+    //   --index FILE --lookup WORD
+    //                print the lines of WORD (repeatable) from a saved index
+    //                without reading the text at all.
+    //   --follow     keep watching a growing file, indexing only what was
+    //                appended and printing the counts of the words appended
+    //                every MS (1000) ms.
+    //   --fused      build part 1 and part 2 from a single read of the file.
+    //   --fused-postings
+    //                the same, but with the part 1 counts read back out of the
+    //                part 2 PostingLists.
+    //   --interned   the same, with every word interned once in a WordDictionary
+    //                and the counts and line lists kept in vectors indexed by
+    //                word ID instead of in maps keyed by std::string.
+    //   --top K      only the K most frequent words, counted in fixed memory
+    //                with M (default 10 * K) Space-Saving counters. Each count
+    //                is at most Error above the true count.
+    //   --dir DIR    index every file under DIR on N threads (0 = one per core)
+    //                into one word -> (file, line) concordance.
+    //   --fast-output  print the part 1 / part 2 reports through a buffered
+    //                ReportWriter instead of std::cout, same layout.
+    //   --out FILE   the same, written straight to FILE.
+    //   --phrase "WORDS"
+    //                lines on which the exact phrase starts (repeatable), from a
+    //                positional index.
+    //   --prefix P   how many words start with P (repeatable), how far P can be
+    //                completed unambiguously and the first few of those words,
+    //                from a radix trie over the vocabulary.
+    //   --distinct P estimate the number of distinct words with a HyperLogLog
+    //                sketch of 2^P (4 - 18) bytes, on N threads (0 = one per
+    //                core), or over every file under DIR.
+    //   --stopwords  leave common words ("the", "and", ...) out of the part 1 /
+    //                part 2 reports (plain, --mmap, --async, --threads, --hash,
+    //                --compact, --fused, --interned), --memory-budget, --top and
+    //                --ngrams. The other modes reject it.
+    //   --memory-budget MB
+    //                exact part 1 counts in about MB megabytes of memory: counts
+    //                that outgrow it are spilled as sorted runs to DIR ($TMPDIR
+    //                or /tmp) and merged back while printing.
+    //   --add-segment DIR
+    //                index the file as a new segment of the store in DIR, its
+    //                lines numbered on from the text already there. Segments
+    //                are merged in the background as they pile up.
+    //   --segments DIR --lookup WORD
+    //                print the lines of WORD (repeatable) across every segment
+    //                in DIR.
+    //   --merge-segments DIR
+    //                merge every segment in DIR into one.
+    //   --context N --lookup WORD
+    //                print every line WORD (repeatable) is on, with N lines either
+    //                side, straight out of the mapped file. The hits come from a
+    //                saved index if one is given, otherwise the file is indexed.
+    //   --wildcard PATTERN
+    //                the lines of every word matching PATTERN (repeatable), where
+    //                '*' is any run of characters and '?' any one character, e.g.
+    //                "*oroth*" or "Dor?thy", found through a trigram index over
+    //                the vocabulary.
+    //   --ngrams N   how often every run of N (1 - 8) adjacent words (2 = pairs,
+    //                3 = triples) occurs, most frequent first, or only the K
+    //                most frequent. At most M (16 or more, default 1048576) are
+    //                counted at once; past that the rarest are pruned, and each
+    //                count may then be up to Error below the true count.
+
+    bool mapped {false};
+    bool async {false};
+    bool hashed {false};
+    bool compact {false};
+    int threads {-1};
+    std::string path {wordsFile};
+    std::string indexPath;
+    std::string saveIndexPath;
+    std::vector<std::string> lookups;
+    bool follow {false};
+    int intervalMs {1000};
+    int fused {0};
+    std::size_t topK {0};
+    std::size_t counters {0};
+    std::string dir;
+    std::vector<std::string> phrases;
+    std::vector<std::string> prefixes;
+    int distinct {0};
+    bool countDistinctWords {false};
+    std::size_t memoryBudget {0};
+    std::string tempDir {SpillingCounter::defaultTempDir()};
+    std::string storeDir;
+    bool addToStore {false};
+    bool mergeStore {false};
+    int context {-1};
+    std::vector<std::string> patterns;
+    int ngrams {0};
+    bool countNGrams {false};
+    for (int i {1}; i < argc; i++) {
+        if (std::strcmp(argv[i], "--mmap") == 0)
+            mapped = true;
+        else if (std::strcmp(argv[i], "--async") == 0)
+            async = true;
+        else if (std::strcmp(argv[i], "--hash") == 0)
+            hashed = true;
+        else if (std::strcmp(argv[i], "--compact") == 0)
+            compact = true;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = std::stoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--save-index") == 0 && i + 1 < argc) {
+            compact = true;
+            saveIndexPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc)
+            indexPath = argv[++i];
+        else if (std::strcmp(argv[i], "--lookup") == 0 && i + 1 < argc)
+            lookups.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "--follow") == 0)
+            follow = true;
+        else if (std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+            intervalMs = std::stoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--fused") == 0)
+            fused = 1;
+        else if (std::strcmp(argv[i], "--fused-postings") == 0)
+            fused = 2;
+        else if (std::strcmp(argv[i], "--interned") == 0)
+            fused = 3;
+        else if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+            topK = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--counters") == 0 && i + 1 < argc)
+            counters = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+            dir = argv[++i];
+        else if (std::strcmp(argv[i], "--phrase") == 0 && i + 1 < argc)
+            phrases.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "--prefix") == 0 && i + 1 < argc)
+            prefixes.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "--distinct") == 0 && i + 1 < argc) {
+            distinct = std::stoi(argv[++i]);
+            countDistinctWords = true;
+        } else if (std::strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc)
+            memoryBudget = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--temp-dir") == 0 && i + 1 < argc)
+            tempDir = argv[++i];
+        else if (std::strcmp(argv[i], "--add-segment") == 0 && i + 1 < argc) {
+            addToStore = true;
+            storeDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--segments") == 0 && i + 1 < argc)
+            storeDir = argv[++i];
+        else if (std::strcmp(argv[i], "--merge-segments") == 0 && i + 1 < argc) {
+            mergeStore = true;
+            storeDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--context") == 0 && i + 1 < argc)
+            context = std::stoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--ngrams") == 0 && i + 1 < argc) {
+            countNGrams = true;
+            ngrams = std::stoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--wildcard") == 0 && i + 1 < argc)
+            patterns.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "--stopwords") == 0)
+            dropStopWords = true;
+        else if (std::strcmp(argv[i], "--fast-output") == 0)
+            reportFd = STDOUT_FILENO;
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            reportFd = open(argv[++i], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (reportFd < 0) {
+                std::cerr << "\nError opening output file!" << std::endl;
+                return 1;
+            }
+        }
+        else
+            path = argv[i];
+    }
+
+    if (dropStopWords && (!lookups.empty() || addToStore || mergeStore || follow || !dir.empty() || !phrases.empty()
+                          || !prefixes.empty() || !patterns.empty() || countDistinctWords)) {
+        std::cerr << "\nError: --stopwords only applies to the part 1 / part 2 reports, --memory-budget, --top and "
+                     "--ngrams!" << std::endl;
+        return 1;
+    }
+
+    if (countNGrams && (ngrams < 1 || ngrams > NGramCounter::maxN)) {
+        std::cerr << "\nError: --ngrams N takes N from 1 to " << NGramCounter::maxN << "!" << std::endl;
+        return 1;
+    }
+    if (countNGrams && counters > 0 && counters < NGramCounter::minCapacity) {
+        std::cerr << "\nError: --ngrams needs --counters M of at least " << NGramCounter::minCapacity << "!"
+                  << std::endl;
+        return 1;
+    }
+    if (countDistinctWords && (distinct < HyperLogLog::minPrecision || distinct > HyperLogLog::maxPrecision)) {
+        std::cerr << "\nError: --distinct P takes P from " << HyperLogLog::minPrecision << " to "
+                  << HyperLogLog::maxPrecision << "!" << std::endl;
+        return 1;
+    }
+    if (!indexPath.empty() && lookups.empty()) {
+        std::cerr << "\nError: --index FILE needs at least one --lookup WORD!" << std::endl;
+        return 1;
+    }
+    if (!lookups.empty() && context < 0 && storeDir.empty() && indexPath.empty()) {
+        std::cerr << "\nError: --lookup needs --index FILE, --segments DIR or --context N!" << std::endl;
+        return 1;
+    }
+
+    if (!lookups.empty() && context >= 0) {
+        showContext(path, indexPath, lookups, context);
+        return finishReports();
+    }
+    if (!lookups.empty() && !storeDir.empty()) {
+        lookupSegments(storeDir, lookups);
+        return finishReports();
+    }
+    if (!lookups.empty()) {
+        lookupWords(indexPath, lookups);
+        return finishReports();
+    }
+    if (addToStore) {
+        addSegment(path, storeDir);
+        return finishReports();
+    }
+    if (mergeStore) {
+        mergeSegments(storeDir);
+        return finishReports();
+    }
+    if (follow) {
+        followFile(path, intervalMs);
+        return finishReports();
+    }
+    if (fused == 3) {
+        partsInterned(path);
+        return finishReports();
+    }
+    if (fused > 0) {
+        partsFused(path, fused == 2);
+        return finishReports();
+    }
+    if (countNGrams) {
+        partNGrams(path, ngrams, topK, counters > 0 ? counters : 1 << 20);
+        return finishReports();
+    }
+    if (topK > 0) {
+        partTopK(path, topK, counters > 0 ? counters : 10 * topK);
+        return finishReports();
+    }
+    if (!phrases.empty()) {
+        findPhrases(path, phrases);
+        return finishReports();
+    }
+    if (!prefixes.empty()) {
+        completePrefixes(path, prefixes);
+        return finishReports();
+    }
+    if (!patterns.empty()) {
+        matchWildcards(path, patterns);
+        return finishReports();
+    }
+    if (memoryBudget > 0) {
+        part1Spilled(path, memoryBudget << 20, tempDir);
+        return finishReports();
+    }
+    if (countDistinctWords) {
+        std::vector<std::string> listErrors;
+        std::vector<std::string> paths {dir.empty() ? std::vector<std::string>{path} : listFiles(dir, listErrors)};
+        for (const auto& error : listErrors)
+            std::cerr << "\nError reading " << error << "!" << std::endl;
+        countDistinct(paths, distinct, threads >= 0 ? static_cast<unsigned>(threads) : 1);
+        return finishReports();
+    }
+    if (!dir.empty()) {
+        partDirectory(dir, threads > 0 ? static_cast<unsigned>(threads) : 0);
+        return finishReports();
+    }
+
+    if (threads >= 0)
+        part1Parallel(path, static_cast<unsigned>(threads));
+    else if (hashed)
+        part1Hashed(path);
+    else if (async)
+        part1Async(path);
+    else if (mapped || compact)
+        part1Mapped(path);
+    else
+        part1(path);
+
+    if (compact)
+        part2Compact(path, saveIndexPath);
+    else if (async)
+        part2Async(path);
+    else if (mapped || hashed || threads >= 0)
+        part2Mapped(path);
+    else
+        part2(path);
+    return finishReports();
 }
 
-void part1() {
-    std::map<std::string, int> words;
+void part1(const std::string& path) {
+    WordCounts words;
     std::string line;
     std::string word;
-    std::ifstream inFile {"../Notes/Challenge3/words.txt"};
+    std::ifstream inFile {path};
 
     if (inFile) {
         std::cout << "Found File!\n" << std::endl;
@@ -94,6 +472,8 @@ void part1() {
 
             while (ss >> word) {
                 word = cleanStr(word);
+                if (dropStopWords && isStopWord(word))
+                    continue;
 
 //                auto iter = words.find(word);
 //
@@ -111,11 +491,11 @@ void part1() {
         std::cerr << "\nError opening input file!" << std::endl;
 }
 
-void part2() {
-    std::map<std::string, std::set<int>> words;
+void part2(const std::string& path) {
+    WordLines words;
     std::string line;
     std::string word;
-    std::ifstream inFile {"../Notes/Challenge3/words.txt"};
+    std::ifstream inFile {path};
 
     if (inFile) {
         std::cout << "Found File!\n" << std::endl;
@@ -127,6 +507,8 @@ void part2() {
 
             while (ss >> word) {
                 word = cleanStr(word);
+                if (dropStopWords && isStopWord(word))
+                    continue;
 
 //                auto iter = words.find(word);
 //
@@ -146,30 +528,594 @@ void part2() {
         std::cerr << "\nError opening input file!" << std::endl;
 }
 
-void displayWords(const std::map<std::string, int>& words) {
-    std::cout << std::setw(12) << std::left << "\nWord"
-              << std::setw(7) << std::right << "Count" << std::endl;
-    std::cout << "===========================" << std::endl;
+void part1Mapped(const std::string& path) {
+    WordCounts words;
+    MappedFile inFile {path};
 
-    for (const auto& pair : words)
-        std::cout << std::setw(12) << std::left << pair.first
-                  << std::setw(7) << std::right << pair.second << "\n";
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        forEachWord(inFile.view(), [&words](std::string_view word, int) {
+            if (!dropStopWords || !isStopWord(word))
+                addWord(words, word);
+        });
+        displayWords(words);
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void part2Mapped(const std::string& path) {
+    WordLines words;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
 
+        forEachWord(inFile.view(), [&words](std::string_view word, int lineCount) {
+            if (!dropStopWords || !isStopWord(word))
+                addWord(words, word, lineCount);
+        });
+        displayWords(words);
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
 }
-void displayWords(const std::map<std::string, std::set<int>>& words) {
+
+void part1Async(const std::string& path) {
+    WordCounts words;
+    AsyncReader inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        if (inFile.forEachWord([&words](std::string_view word, int) {
+                if (!dropStopWords || !isStopWord(word))
+                    addWord(words, word);
+            }))
+            displayWords(words);
+        else
+            std::cerr << "\nError reading input file!" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void part2Async(const std::string& path) {
+    WordLines words;
+    AsyncReader inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        if (inFile.forEachWord([&words](std::string_view word, int lineCount) {
+                if (!dropStopWords || !isStopWord(word))
+                    addWord(words, word, lineCount);
+            }))
+            displayWords(words);
+        else
+            std::cerr << "\nError reading input file!" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void part1Spilled(const std::string& path, std::size_t budgetBytes, const std::string& tempDir) {
+    // The read buffers come out of the budget too: three of them, taking a
+    // quarter of it at most and never more than the usual 4 MB each
+    std::size_t bufferBytes {std::clamp<std::size_t>(budgetBytes / 12, 64 << 10, 4 << 20)};
+    SpillingCounter words {budgetBytes - 3 * bufferBytes, tempDir};
+    AsyncReader inFile {path, bufferBytes, 3};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        if (!inFile.forEachWord([&words](std::string_view word, int) {
+                if (!dropStopWords || !isStopWord(word))
+                    words.add(word);
+            })) {
+            std::cerr << "\nError reading input file!" << std::endl;
+            return;
+        }
+
+        // The counts stream out of the merge, so they go straight to a
+        // ReportWriter rather than into a container for displayWords()
+        std::cout << std::flush;
+        ReportWriter writer {reportFd >= 0 ? reportFd : STDOUT_FILENO};
+        writer.writeCountsHeader();
+        if (!words.finish([&writer](std::string_view word, std::uint64_t count) {
+                writer.writeCount(word, static_cast<long long>(count));
+            }))
+            std::cerr << "\nError writing temporary files in " << tempDir << "!" << std::endl;
+        reportFailed |= !writer.flush();
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void part1Parallel(const std::string& path, unsigned threads) {
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+        displayWords(countWordsParallel(inFile.view(), threads, dropStopWords));
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void part1Hashed(const std::string& path) {
+    WordTable words;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        forEachWord(inFile.view(), [&words](std::string_view word, int) {
+            if (!dropStopWords || !isStopWord(word))
+                words.add(word);
+        });
+        displayWords(words);
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void part2Compact(const std::string& path, const std::string& saveIndexPath) {
+    WordPostings words;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        forEachWord(inFile.view(), [&words](std::string_view word, int lineCount) {
+            if (!dropStopWords || !isStopWord(word))
+                addWord(words, word, lineCount);
+        });
+        if (!saveIndexPath.empty() && !writeIndex(saveIndexPath, words))
+            std::cerr << "\nError writing index file!" << std::endl;
+        displayWords(words);
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void lookupWords(const std::string& indexPath, const std::vector<std::string>& lookups) {
+    IndexView index {indexPath};
+
+    if (index)
+        displayLookups(index, lookups);
+    else
+        std::cerr << "\nError opening index file!" << std::endl;
+}
+
+void lookupSegments(const std::string& storeDir, const std::vector<std::string>& lookups) {
+    SegmentStore store {storeDir};
+
+    if (store)
+        displayLookups(store, lookups);
+    else
+        std::cerr << "\nError opening segment store!" << std::endl;
+}
+
+template <typename Index>
+void displayLookups(const Index& index, const std::vector<std::string>& lookups) {
     std::cout << std::setw(12) << std::left << "\nWord"
               << "Line Occurrences" << std::endl;
     std::cout << "======================================================" << std::endl;
 
-    for (const auto& pair : words) {
-        std::cout << std::setw(12) << std::left << pair.first
+    for (const auto& word : lookups) {
+        std::cout << std::setw(12) << std::left << word
                   << std::left << "[ ";
-        for (const auto& i : pair.second)
+        for (const auto& i : lookupLines(index, word))
             std::cout << i << " ";
         std::cout << "]\n";
     }
 }
 
+void addSegment(const std::string& path, const std::string& storeDir) {
+    SegmentStore store {storeDir};
+    MappedFile inFile {path};
+
+    if (!store)
+        std::cerr << "\nError opening segment store!" << std::endl;
+    else if (!inFile)
+        std::cerr << "\nError opening input file!" << std::endl;
+    else {
+        store.startBackgroundMerges();
+        if (!store.addText(inFile.view())) {
+            std::cerr << "\nError writing segment!" << std::endl;
+            return;
+        }
+        store.waitForMerges();
+        displaySegments(store);
+    }
+}
+
+void showContext(const std::string& path, const std::string& indexPath, const std::vector<std::string>& lookups,
+                 int context) {
+    MappedFile inFile {path};
+    if (!inFile) {
+        std::cerr << "\nError opening input file!" << std::endl;
+        return;
+    }
+    LineIndex lines {inFile.view()};
+
+    if (!indexPath.empty()) {
+        IndexView index {indexPath};
+        if (!index) {
+            std::cerr << "\nError opening index file!" << std::endl;
+            return;
+        }
+        for (const auto& word : lookups)
+            displayContext(word, index.lookup(word), lines, context);
+    } else {
+        InternedIndex index;
+        index.build(inFile.view());
+        for (const auto& word : lookups) {
+            std::uint32_t id {index.words.find(word)};
+            displayContext(word, id != WordDictionary::none ? index.lines[id].view() : PostingView{}, lines, context);
+        }
+    }
+}
+
+// Hit lines are marked with '>', runs of lines that overlap or touch are
+// printed once and separate runs are split by "--", the way grep -C does it
+template <typename Hits>
+void displayContext(const std::string& word, const Hits& hits, const LineIndex& lines, int context) {
+    std::cout << "\n" << word << "\n";
+    std::cout << "======================================================" << std::endl;
+
+    int printed {0};
+    auto next = hits.begin();
+    while (next != hits.end()) {
+        int first {std::max(*next - context, printed + 1)};
+        if (printed > 0 && first > printed + 1)
+            std::cout << "--\n";
+
+        // Extend the run while the next hit's context joins onto it
+        int last {*next + context};
+        std::set<int> marked;
+        for (; next != hits.end() && *next - context <= last + 1; ++next) {
+            marked.insert(*next);
+            last = *next + context;
+        }
+        last = std::min(last, static_cast<int>(lines.size()));
+
+        for (int n {first}; n <= last; n++)
+            std::cout << (marked.count(n) > 0 ? "> " : "  ") << std::setw(8) << std::right << n << "  "
+                      << lines.getLine(n) << "\n";
+        printed = last;
+    }
+}
+
+void mergeSegments(const std::string& storeDir) {
+    SegmentStore store {storeDir};
+
+    if (!store)
+        std::cerr << "\nError opening segment store!" << std::endl;
+    else if (!store.compact())
+        std::cerr << "\nError writing segment!" << std::endl;
+    else
+        displaySegments(store);
+}
+
+void displaySegments(const SegmentStore& store) {
+    std::cout << std::setw(24) << std::left << "\nSegment"
+              << std::setw(16) << std::right << "Lines"
+              << std::setw(10) << std::right << "Words"
+              << std::setw(8) << std::right << "Level" << std::endl;
+    std::cout << "=========================================================" << std::endl;
+
+    for (const auto& segment : *store.snapshot())
+        std::cout << std::setw(23) << std::left << segment.name
+                  << std::setw(16) << std::right
+                  << std::to_string(segment.lineBase + 1) + "-" + std::to_string(segment.lineBase + segment.lineCount)
+                  << std::setw(10) << std::right << segment.index->size()
+                  << std::setw(8) << std::right << segment.level << "\n";
+}
+
+void followFile(const std::string& path, int intervalMs) {
+    FollowIndexer indexer {path};
+
+    while (true) {
+        WordCounts delta;
+        if (!indexer.poll(delta)) {
+            std::cerr << "\nError opening input file!" << std::endl;
+            return;
+        }
+
+        if (indexer.restarted())
+            std::cout << "\nFile was truncated or replaced, indexing it again from the start" << std::endl;
+        if (!delta.empty()) {
+            std::cout << "\nIndexed up to line " << indexer.linesIndexed()
+                      << " (" << indexer.bytesIndexed() << " bytes), words added since the last poll:" << std::endl;
+            displayWords(delta);
+            std::cout << std::flush;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{intervalMs});
+    }
+}
+
+void partsFused(const std::string& path, bool countsFromLines) {
+    WordCounts counts;
+    WordPostings lines;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        if (countsFromLines) {
+            buildPostings(inFile.view(), lines, dropStopWords);
+            counts = countsFromPostings(lines);
+        } else
+            buildIndexes(inFile.view(), counts, lines, dropStopWords);
+
+        std::cout << "Found File!\n" << std::endl;
+        displayWords(counts);
+        std::cout << "Found File!\n" << std::endl;
+        displayWords(lines);
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void partsInterned(const std::string& path) {
+    InternedIndex index;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        forEachWord(inFile.view(), [&index](std::string_view word, int lineCount) {
+            if (!dropStopWords || !isStopWord(word))
+                index.add(word, lineCount);
+        });
+
+        std::cout << "Found File!\n" << std::endl;
+        reportCounts(index.sortedCounts());
+        std::cout << "Found File!\n" << std::endl;
+        reportLines(index.sortedLines());
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void partTopK(const std::string& path, std::size_t k, std::size_t counters) {
+    SpaceSaving words {counters};
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        forEachWord(inFile.view(), [&words](std::string_view word, int) {
+            if (!dropStopWords || !isStopWord(word))
+                words.add(word);
+        });
+        displayWords(words.top(k));
+        std::cout << "\n" << words.streamSize() << " words, any word not listed occurs at most "
+                  << words.minCount() << " times" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void partNGrams(const std::string& path, int n, std::size_t k, std::size_t capacity) {
+    NGramCounter ngrams {n, capacity};
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+
+        // With stopwords left out, the n-grams are runs of the words that remain
+        forEachWord(inFile.view(), [&ngrams](std::string_view word, int) {
+            if (!dropStopWords || !isStopWord(word))
+                ngrams.add(word);
+        });
+        displayWords(ngrams.top(k));
+        std::cout << "\n" << ngrams.streamSize() << " " << ngrams.order() << "-grams, any not listed occurs at most "
+                  << ngrams.floor() << " times" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void partDirectory(const std::string& dir, unsigned threads) {
+    DirectoryIndexer indexer;
+    MultiFileIndex index {indexer.index(dir, threads)};
+
+    for (const auto& error : index.errors)
+        std::cerr << "\nError reading " << error << "!" << std::endl;
+    if (!index.files.empty())
+        displayWords(index);
+    else
+        std::cerr << "\nNo files found in " << dir << "!" << std::endl;
+}
+
+void findPhrases(const std::string& path, const std::vector<std::string>& phrases) {
+    PositionalIndex index;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+        index.build(inFile.view());
+
+        std::cout << std::setw(24) << std::left << "\nPhrase"
+                  << "Line Occurrences" << std::endl;
+        std::cout << "======================================================" << std::endl;
+        for (const auto& phrase : phrases) {
+            std::cout << std::setw(24) << std::left << phrase
+                      << std::left << "[ ";
+            for (const auto& line : index.findPhrase(phrase))
+                std::cout << line << " ";
+            std::cout << "]\n";
+        }
+        std::cout << "\n" << index.tokenCount() << " positions in "
+                  << index.memoryUsage() << " bytes" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void completePrefixes(const std::string& path, const std::vector<std::string>& prefixes) {
+    WordCounts words;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+        forEachWord(inFile.view(), [&words](std::string_view word, int) {
+            addWord(words, word);
+        });
+        VocabularyTrie trie {words};
+
+        std::cout << std::setw(12) << std::left << "\nPrefix"
+                  << std::setw(7) << std::right << "Count"
+                  << "  " << std::setw(14) << std::left << "Completes To"
+                  << "Words" << std::endl;
+        std::cout << "======================================================" << std::endl;
+        for (const auto& prefix : prefixes) {
+            std::cout << std::setw(12) << std::left << prefix
+                      << std::setw(7) << std::right << trie.countPrefix(prefix)
+                      << "  " << std::setw(14) << std::left << trie.longestCommonPrefix(prefix)
+                      << "[ ";
+            for (const auto& word : trie.complete(prefix, 10))
+                std::cout << word << " ";
+            std::cout << "]\n";
+        }
+        std::cout << "\n" << trie.size() << " words in "
+                  << trie.memoryUsage() << " bytes" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void matchWildcards(const std::string& path, const std::vector<std::string>& patterns) {
+    InternedIndex index;
+    MappedFile inFile {path};
+
+    if (inFile) {
+        std::cout << "Found File!\n" << std::endl;
+        index.build(inFile.view());
+        auto vocabulary = index.sortedLines();
+        TrigramIndex trigrams {vocabulary};
+
+        for (const auto& pattern : patterns) {
+            std::vector<std::uint32_t> matches {trigrams.match(pattern)};
+            std::cout << std::setw(12) << std::left << "\n" + pattern
+                      << matches.size() << " words" << std::endl;
+            std::cout << "======================================================" << std::endl;
+
+            LineList lines;
+            for (auto id : matches) {
+                std::cout << std::setw(12) << std::left << vocabulary[id].first
+                          << std::left << "[ ";
+                for (int line : vocabulary[id].second) {
+                    std::cout << line << " ";
+                    lines.push_back(line);
+                }
+                std::cout << "]\n";
+            }
+            std::sort(lines.begin(), lines.end());
+            lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+            std::cout << std::setw(12) << std::left << "(any)" << "[ ";
+            for (int line : lines)
+                std::cout << line << " ";
+            std::cout << "]\n";
+        }
+        std::cout << "\n" << trigrams.size() << " words in "
+                  << trigrams.memoryUsage() << " bytes" << std::endl;
+    } else
+        std::cerr << "\nError opening input file!" << std::endl;
+}
+
+void countDistinct(const std::vector<std::string>& paths, int precision, unsigned threads) {
+    HyperLogLog words {precision};
+
+    for (const auto& path : paths) {
+        MappedFile inFile {path};
+        if (!inFile) {
+            std::cerr << "\nError opening input file " << path << "!" << std::endl;
+            continue;
+        }
+        words.merge(sketchWordsParallel(inFile.view(), words.precision(), threads));
+    }
+
+    double estimate {words.estimate()};
+    std::cout << std::setw(24) << std::left << "Distinct words"
+              << std::fixed << std::setprecision(0) << estimate << "\n"
+              << std::setw(24) << std::left << "Standard error"
+              << std::setprecision(2) << words.relativeError() * 100 << "% (+/- "
+              << std::setprecision(0) << estimate * words.relativeError() << ")\n"
+              << std::setw(24) << std::left << "Sketch"
+              << words.memoryUsage() << " bytes over " << paths.size() << " file(s)" << std::endl;
+}
+
+template <typename Pairs>
+void reportCounts(const Pairs& words) {
+    if (reportFd < 0)
+        displayCounts(words);
+    else {
+        // Anything already in std::cout has to come out first
+        std::cout << std::flush;
+        ReportWriter writer {reportFd};
+        writer.writeCounts(words);
+        reportFailed |= !writer.flush();
+    }
+}
+
+template <typename Map>
+void reportLines(const Map& words) {
+    if (reportFd < 0)
+        displayLines(words);
+    else {
+        std::cout << std::flush;
+        ReportWriter writer {reportFd};
+        writer.writeLines(words);
+        reportFailed |= !writer.flush();
+    }
+}
+
+void displayWords(const WordCounts& words) {
+    reportCounts(words);
+}
+
+void displayWords(const WordTable& words) {
+    reportCounts(words.sorted());
+}
+
+void displayWords(const std::vector<SpaceSaving::Entry>& words) {
+    std::cout << std::setw(12) << std::left << "\nWord"
+              << std::setw(7) << std::right << "Count"
+              << std::setw(7) << std::right << "Error" << std::endl;
+    std::cout << "==================================" << std::endl;
+
+    for (const auto& entry : words)
+        std::cout << std::setw(12) << std::left << entry.word
+                  << std::setw(7) << std::right << entry.count
+                  << std::setw(7) << std::right << entry.error << "\n";
+}
+
+void displayWords(const std::vector<NGramCounter::Entry>& ngrams) {
+    std::cout << std::setw(32) << std::left << "\nWords"
+              << std::setw(7) << std::right << "Count"
+              << std::setw(7) << std::right << "Error" << std::endl;
+    std::cout << "=====================================================" << std::endl;
+
+    for (const auto& entry : ngrams)
+        std::cout << std::setw(31) << std::left << entry.words
+                  << std::setw(7) << std::right << entry.count
+                  << std::setw(7) << std::right << entry.error << "\n";
+}
+
+void displayWords(const MultiFileIndex& index) {
+    std::cout << std::setw(6) << std::left << "\nFile" << "Path" << std::endl;
+    std::cout << "======================================================" << std::endl;
+    for (std::size_t i {0}; i < index.files.size(); i++)
+        std::cout << std::setw(5) << std::left << i << index.files[i] << "\n";
+
+    std::cout << std::setw(12) << std::left << "\nWord"
+              << "File:Line Occurrences" << std::endl;
+    std::cout << "======================================================" << std::endl;
+
+    for (const auto& pair : index.words) {
+        std::cout << std::setw(12) << std::left << pair.first
+                  << std::left << "[ ";
+        for (const auto& fileLine : pair.second)
+            std::cout << fileLine.file << ":" << fileLine.line << " ";
+        std::cout << "]\n";
+    }
+}
+
+void displayWords(const WordLines& words) {
+    reportLines(words);
+}
+
+void displayWords(const WordPostings& words) {
+    reportLines(words);
+}
+
 std::string cleanStr(const std::string& str) {
     std::string result;
     for (const auto& c : str) {
@@ -180,3 +1126,15 @@ std::string cleanStr(const std::string& str) {
 
     return result;
 }
+
+// Flushes what the reports still hold and closes an --out file. Returns the
+// exit status: 1 if any of the output could not be written.
+int finishReports() {
+    std::cout << std::flush;
+    bool failed {reportFailed || !std::cout};
+    if (reportFd > STDOUT_FILENO && close(reportFd) != 0)
+        failed = true;
+    if (failed)
+        std::cerr << "\nError writing output!" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+#ifndef CPPNOTES_CORPUSGENERATOR_H
+#define CPPNOTES_CORPUSGENERATOR_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <ostream>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Synthetic words.txt style text.
+// The vocabulary is vocabularySize random words of 1 to 20 letters, some of them
+// capitalised, with the odd trailing '.', ',', ';' or ':' and ~70 byte lines.
+// Word ranks are drawn from a Zipf distribution with the given exponent
+// (rank r has weight 1 / r^s, ~1.0 for natural language); an exponent of 0
+// picks every word equally often. The same settings always give the same text.
+class CorpusGenerator {
+private:
+    std::mt19937_64 rng;
+    std::vector<std::string> vocabulary;
+    std::vector<double> cumulative;     // Zipf CDF over ranks, empty when uniform
+    std::size_t lineLength {0};
+
+    const std::string& nextWord() {
+        if (cumulative.empty())
+            return vocabulary[std::uniform_int_distribution<std::size_t>{0, vocabulary.size() - 1}(rng)];
+
+        double u {std::uniform_real_distribution<double>{0.0, cumulative.back()}(rng)};
+        auto rank = std::upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+        return vocabulary[std::min(static_cast<std::size_t>(rank), vocabulary.size() - 1)];
+    }
+
+public:
+    CorpusGenerator(std::uint64_t seed, std::size_t vocabularySize, double zipfExponent = 0.0) : rng{seed} {
+        std::uniform_int_distribution<int> letter {'a', 'z'};
+        std::uniform_int_distribution<int> length {1, 20};
+        std::uniform_int_distribution<int> percent {0, 99};
+
+        if (vocabularySize == 0)
+            vocabularySize = 1;
+        vocabulary.reserve(vocabularySize);
+        for (std::size_t i {0}; i < vocabularySize; i++) {
+            std::string word;
+            // Short words are far more common than long ones
+            int size {std::min(length(rng), length(rng))};
+            for (int j {0}; j < size; j++)
+                word += static_cast<char>(letter(rng));
+            if (percent(rng) < 20)
+                word[0] = static_cast<char>(word[0] - 'a' + 'A');
+            vocabulary.push_back(word);
+        }
+
+        if (zipfExponent > 0.0) {
+            cumulative.reserve(vocabularySize);
+            double sum {0.0};
+            for (std::size_t rank {1}; rank <= vocabularySize; rank++) {
+                sum += 1.0 / std::pow(static_cast<double>(rank), zipfExponent);
+                cumulative.push_back(sum);
+            }
+        }
+    }
+
+    // Appends words to text until it has grown by at least bytes bytes,
+    // always stopping at the end of a word
+    void append(std::string& text, std::size_t bytes) {
+        const char punctuation[] {'.', ',', ';', ':'};
+        std::uniform_int_distribution<int> percent {0, 99};
+        std::size_t target {text.size() + bytes};
+
+        while (text.size() < target) {
+            const std::string& word {nextWord()};
+            text += word;
+            int roll {percent(rng)};
+            if (roll < 8)
+                text += punctuation[roll % 4];
+            lineLength += word.size();
+
+            if (lineLength > 70) {
+                text += '\n';
+                lineLength = 0;
+            } else {
+                text += ' ';
+                lineLength++;
+            }
+        }
+    }
+
+    // Streams about bytes bytes of text to os in 1 MB pieces, so corpora far
+    // larger than memory can be written to disk
+    void write(std::ostream& os, std::size_t bytes) {
+        std::string buffer;
+        std::size_t written {0};
+        while (written < bytes && os) {
+            buffer.clear();
+            append(buffer, std::min<std::size_t>(bytes - written, 1 << 20));
+            os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            written += buffer.size();
+        }
+        os.put('\n');
+    }
+};
+
+// Builds a synthetic corpus of about targetBytes bytes in memory
+inline std::string generateCorpus(std::uint64_t seed, std::size_t vocabularySize, std::size_t targetBytes,
+                                  double zipfExponent = 0.0) {
+    CorpusGenerator generator {seed, vocabularySize, zipfExponent};
+    std::string corpus;
+    corpus.reserve(targetBytes + 64);
+    generator.append(corpus, targetBytes);
+    corpus += '\n';
+    return corpus;
+}
+
+#endif //CPPNOTES_CORPUSGENERATOR_H
@@ -0,0 +1,262 @@
+#ifndef CPPNOTES_DIRECTORYINDEXER_H
+#define CPPNOTES_DIRECTORYINDEXER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include "MappedFile.h"
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "ParallelCount.h"
+
+struct FileLine {
+    std::uint32_t file;     // index into MultiFileIndex::files
+    std::uint32_t line;
+};
+
+// word -> every (file, line) it appears on, ordered by file then line
+struct MultiFileIndex {
+    std::vector<std::string> files;
+    std::map<std::string, std::vector<FileLine>, std::less<>> words;
+    std::vector<std::string> errors;    // "path: reason" for everything that could not be read
+};
+
+// Every regular file under dir, recursively, sorted by path. A directory or
+// entry that cannot be read is skipped and added to errors as "path: reason",
+// and the rest of the tree is still listed. Like recursive_directory_iterator,
+// symlinks to directories are not followed.
+inline std::vector<std::string> listFiles(const std::string& dir, std::vector<std::string>& errors) {
+    std::vector<std::string> files;
+    std::vector<std::filesystem::path> directories {dir};
+    while (!directories.empty()) {
+        std::filesystem::path current {std::move(directories.back())};
+        directories.pop_back();
+
+        std::error_code error;
+        std::filesystem::directory_iterator iter {current, error};
+        for (std::filesystem::directory_iterator end; !error && iter != end; iter.increment(error)) {
+            std::error_code entryError;
+            if (iter->is_directory(entryError) && !iter->is_symlink(entryError))
+                directories.push_back(iter->path());
+            else if (iter->is_regular_file(entryError))
+                files.push_back(iter->path().string());
+            if (entryError)
+                errors.push_back(iter->path().string() + ": " + entryError.message());
+        }
+        if (error)
+            errors.push_back(current.string() + ": " + error.message());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// Indexes every regular file under a directory on a pool of threads.
+//
+// Each worker owns a deque of tasks. It pops its own work from the back and,
+// when it runs dry, steals from the front of another worker's deque. Files
+// start out dealt round-robin as one task each; a worker that picks up a file
+// bigger than chunkBytes splits it at line boundaries into chunk tasks and
+// pushes them onto its own deque, where idle workers can steal them. That way
+// a few huge files and thousands of tiny ones still keep every core busy.
+//
+// Chunks are indexed with line numbers relative to the chunk, and the merge
+// shifts them by the number of lines in the chunks before them.
+class DirectoryIndexer {
+private:
+    struct Task {
+        std::uint32_t file;
+        std::uint32_t chunk;        // position of this chunk within its file
+        std::size_t begin;
+        std::size_t end;            // 0 = whole file, not split yet
+        // The file's mapping, shared by all of its chunks so it is only mapped
+        // once. Null until the file has been opened.
+        std::shared_ptr<const MappedFile> mapping;
+    };
+
+    struct ChunkResult {
+        std::uint32_t file;
+        std::uint32_t chunk;
+        int lines;                  // '\n's in the chunk
+        WordPostings words;
+    };
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        std::vector<ChunkResult> results;
+        std::vector<std::string> errors;
+    };
+
+    std::vector<std::string> files;
+    std::vector<Worker> workers;
+    std::atomic<std::size_t> pending {0};      // tasks not finished yet
+    std::atomic<std::size_t> queued {0};       // tasks sitting in a deque
+    std::mutex idleLock;
+    std::condition_variable idle;               // a task was queued, or the last one finished
+    std::size_t chunkBytes;
+
+    void push(std::size_t self, Task task) {
+        pending.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> guard {workers[self].lock};
+            workers[self].tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1);
+        // Taking idleLock orders this with a worker that is about to park
+        { std::lock_guard<std::mutex> guard {idleLock}; }
+        idle.notify_all();
+    }
+
+    bool take(std::size_t self, Task& task) {
+        {
+            std::lock_guard<std::mutex> guard {workers[self].lock};
+            if (!workers[self].tasks.empty()) {
+                task = std::move(workers[self].tasks.back());
+                workers[self].tasks.pop_back();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        for (std::size_t i {1}; i < workers.size(); i++) {
+            Worker& victim {workers[(self + i) % workers.size()]};
+            std::lock_guard<std::mutex> guard {victim.lock};
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(std::size_t self, Task& task) {
+        if (task.mapping == nullptr) {
+            task.mapping = std::make_shared<const MappedFile>(files[task.file]);
+            if (!*task.mapping) {
+                workers[self].errors.push_back(files[task.file] + ": " + std::strerror(errno));
+                return;
+            }
+        }
+        std::string_view text {task.mapping->view()};
+
+        if (task.end == 0 && text.size() > chunkBytes) {
+            std::vector<std::string_view> chunks {splitAtLines(text, text.size() / chunkBytes + 1)};
+            for (std::size_t i {0}; i < chunks.size(); i++) {
+                auto begin = static_cast<std::size_t>(chunks[i].data() - text.data());
+                push(self, {task.file, static_cast<std::uint32_t>(i), begin, begin + chunks[i].size(), task.mapping});
+            }
+            return;
+        }
+
+        if (task.end != 0)
+            text = text.substr(task.begin, task.end - task.begin);
+
+        ChunkResult result {task.file, task.chunk, 0, {}};
+        forEachWord(text, [&result](std::string_view word, int line) {
+            addWord(result.words, word, line);
+        }, 0);
+        result.lines = static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+        workers[self].results.push_back(std::move(result));
+    }
+
+    // Runs tasks until every task is finished, parking while there is
+    // nothing to take but other workers may still push some
+    void work(std::size_t self) {
+        Task task {};
+        while (true) {
+            if (take(self, task)) {
+                run(self, task);
+                task.mapping.reset();
+                if (pending.fetch_sub(1) == 1) {
+                    { std::lock_guard<std::mutex> guard {idleLock}; }
+                    idle.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> guard {idleLock};
+            idle.wait(guard, [this]() { return pending.load() == 0 || queued.load() > 0; });
+            if (pending.load() == 0)
+                return;
+        }
+    }
+
+    MultiFileIndex merge() {
+        std::vector<ChunkResult> results;
+        for (auto& worker : workers)
+            for (auto& result : worker.results)
+                results.push_back(std::move(result));
+        std::sort(results.begin(), results.end(), [](const ChunkResult& lhs, const ChunkResult& rhs) {
+            return lhs.file != rhs.file ? lhs.file < rhs.file : lhs.chunk < rhs.chunk;
+        });
+
+        // Walking the chunks in (file, chunk) order appends every word's
+        // lines in ascending order, so nothing needs sorting afterwards
+        MultiFileIndex merged;
+        merged.files = files;
+        for (auto& worker : workers)
+            merged.errors.insert(merged.errors.end(), worker.errors.begin(), worker.errors.end());
+        std::sort(merged.errors.begin(), merged.errors.end());
+        std::uint32_t file {0};
+        int lineBase {1};
+        for (const auto& result : results) {
+            if (result.file != file) {
+                file = result.file;
+                lineBase = 1;
+            }
+            for (const auto& pair : result.words) {
+                auto& lines = wordEntry(merged.words, pair.first);
+                for (int line : pair.second)
+                    lines.push_back({file, static_cast<std::uint32_t>(line + lineBase)});
+            }
+            lineBase += result.lines;
+        }
+        workers.clear();
+        return merged;
+    }
+
+public:
+    explicit DirectoryIndexer(std::size_t chunkBytes = 16 << 20) : chunkBytes{chunkBytes > 0 ? chunkBytes : 1} { }
+
+    // Returns an empty index (no files) if dir cannot be read. Whatever could
+    // not be listed or read is in the index's errors, and files that could not
+    // be read add no words.
+    MultiFileIndex index(const std::string& dir, unsigned threads) {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+        std::vector<std::string> listErrors;
+        files = listFiles(dir, listErrors);
+
+        workers = std::vector<Worker>(threads);
+        for (std::size_t i {0}; i < files.size(); i++)
+            push(i % threads, {static_cast<std::uint32_t>(i), 0, 0, 0, nullptr});
+
+        std::vector<std::thread> pool;
+        for (std::size_t i {1}; i < threads; i++)
+            pool.emplace_back(&DirectoryIndexer::work, this, i);
+        work(0);
+        for (auto& thread : pool)
+            thread.join();
+
+        MultiFileIndex merged {merge()};
+        merged.errors.insert(merged.errors.begin(), listErrors.begin(), listErrors.end());
+        return merged;
+    }
+};
+
+#endif //CPPNOTES_DIRECTORYINDEXER_H
@@ -0,0 +1,113 @@
+#ifndef CPPNOTES_FOLLOWINDEXER_H
+#define CPPNOTES_FOLLOWINDEXER_H
+
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Tokenizer.h"
+#include "WordIndex.h"
+
+// Keeps the part 1 counts and part 2 line sets of a file that is still being
+// appended to (a log, say) up to date. It remembers how many bytes and lines it
+// has already indexed, and each poll() only reads and tokenizes what was
+// appended since. A trailing line without its '\n' is left for the next poll,
+// so a word that is still being written is never counted in two halves.
+//
+// The file is told apart from a new one at the same path (log rotation) by
+// its device and inode number, so a replacement is indexed from the start
+// even if it is already as big as the old file was.
+class FollowIndexer {
+private:
+    std::string path;
+    dev_t device {0};
+    ino_t inode {0};
+    bool restartedLast {false};
+    std::uint64_t offset {0};
+    int lineCount {1};
+    WordCounts counts;
+    WordLines lines;
+    std::string buffer;
+    std::size_t blockSize {1 << 20};
+
+    void reset() {
+        offset = 0;
+        lineCount = 1;
+        counts.clear();
+        lines.clear();
+    }
+
+public:
+    explicit FollowIndexer(std::string path) : path{std::move(path)} { }
+
+    // Indexes whatever complete lines were appended since the last poll and
+    // adds their words to delta. Returns false if the file could not be read.
+    // If the file shrank, or path is now a different file, it was truncated or
+    // rotated, and indexing restarts.
+    bool poll(WordCounts& delta) {
+        int fd {open(path.c_str(), O_RDONLY)};
+        if (fd < 0)
+            return false;
+
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return false;
+        }
+        auto size = static_cast<std::uint64_t>(info.st_size);
+        bool replaced {info.st_dev != device || info.st_ino != inode};
+        restartedLast = (replaced && offset > 0) || size < offset;
+        if (restartedLast)
+            reset();
+        device = info.st_dev;
+        inode = info.st_ino;
+
+        bool ok {true};
+        while (offset < size) {
+            std::size_t want {static_cast<std::size_t>(std::min<std::uint64_t>(blockSize, size - offset))};
+            buffer.resize(want);
+            ssize_t got {pread(fd, buffer.data(), want, static_cast<off_t>(offset))};
+            if (got <= 0) {
+                ok = got == 0;
+                break;
+            }
+
+            std::string_view block {buffer.data(), static_cast<std::size_t>(got)};
+            std::size_t newline {block.rfind('\n')};
+            if (newline == std::string_view::npos) {
+                // One line longer than the block: read a bigger block, unless
+                // the line simply is not finished yet
+                if (static_cast<std::size_t>(got) == blockSize) {
+                    blockSize *= 2;
+                    continue;
+                }
+                break;
+            }
+
+            block = block.substr(0, newline + 1);
+            forEachWord(block, [this, &delta](std::string_view word, int line) {
+                addWord(counts, word);
+                addWord(lines, word, line);
+                addWord(delta, word);
+            }, lineCount);
+
+            lineCount += static_cast<int>(std::count(block.begin(), block.end(), '\n'));
+            offset += block.size();
+        }
+        close(fd);
+        return ok;
+    }
+
+    const WordCounts& wordCounts() const { return counts; }
+    const WordLines& wordLines() const { return lines; }
+    std::uint64_t bytesIndexed() const { return offset; }
+    // Whether the last poll() found the file truncated or replaced and started over
+    bool restarted() const { return restartedLast; }
+    int linesIndexed() const { return lineCount - 1; }
+};
+
+#endif //CPPNOTES_FOLLOWINDEXER_H
@@ -0,0 +1,38 @@
+#ifndef CPPNOTES_FUSEDBUILDER_H
+#define CPPNOTES_FUSEDBUILDER_H
+
+#include <string_view>
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "StopWords.h"
+
+// Builds the part 1 counts and the part 2 concordance from a single pass over
+// text, instead of part1() and part2() each reading and tokenizing it.
+// Stopwords are left out of both if skipStopWords is set.
+inline void buildIndexes(std::string_view text, WordCounts& counts, WordPostings& lines, bool skipStopWords = false) {
+    forEachWord(text, [&counts, &lines, skipStopWords](std::string_view word, int lineCount) {
+        if (skipStopWords && isStopWord(word))
+            return;
+        addWord(counts, word);
+        addWord(lines, word, lineCount);
+    });
+}
+
+// Builds only the concordance; PostingList keeps the total number of
+// occurrences, so the counts can be read back from it with countsFromPostings()
+// for one map lookup per word instead of two.
+inline void buildPostings(std::string_view text, WordPostings& lines, bool skipStopWords = false) {
+    forEachWord(text, [&lines, skipStopWords](std::string_view word, int lineCount) {
+        if (!skipStopWords || !isStopWord(word))
+            addWord(lines, word, lineCount);
+    });
+}
+
+inline WordCounts countsFromPostings(const WordPostings& lines) {
+    WordCounts counts;
+    for (const auto& pair : lines)
+        counts.emplace_hint(counts.end(), pair.first, pair.second.totalOccurrences());
+    return counts;
+}
+
+#endif //CPPNOTES_FUSEDBUILDER_H
@@ -0,0 +1,121 @@
+#ifndef CPPNOTES_HYPERLOGLOG_H
+#define CPPNOTES_HYPERLOGLOG_H
+
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include "Tokenizer.h"
+#include "WordHash.h"
+#include "ParallelCount.h"
+
+// Estimates the number of distinct words in a stream of any length in 2^precision
+// bytes of memory (4 KB at the default precision of 12).
+//
+// Each word's hash picks one of m = 2^precision registers with its top bits,
+// and the register keeps the longest run of leading zeros seen in the
+// remaining bits. n distinct words push those runs to about log2(n / m), and
+// the harmonic mean over all registers turns them back into an estimate whose
+// standard error is 1.04 / sqrt(m). Repeats of a word hash the same way, so
+// they never change anything.
+//
+// Two sketches of the same precision merge by taking the larger of every
+// register, which gives exactly the sketch of both streams together: threads
+// and files can each fill their own and combine them at the end.
+class HyperLogLog {
+private:
+    int bits;
+    std::vector<std::uint8_t> registers;
+
+public:
+    static constexpr int minPrecision {4};
+    static constexpr int maxPrecision {18};
+
+    // precision is clamped to minPrecision - maxPrecision, so callers taking
+    // it from a user should check the range themselves
+    explicit HyperLogLog(int precision = 12)
+        : bits{precision < minPrecision ? minPrecision : precision > maxPrecision ? maxPrecision : precision},
+          registers(std::size_t{1} << bits, 0) { }
+
+    void add(std::string_view word) { addHash(hashWord(word)); }
+
+    void addHash(std::uint64_t hash) {
+        std::size_t index {static_cast<std::size_t>(hash >> (64 - bits))};
+        // The guard bit caps the run at 64 - bits zeros, so the rest is never 0
+        std::uint64_t rest {(hash << bits) | (std::uint64_t{1} << (bits - 1))};
+        auto rank = static_cast<std::uint8_t>(__builtin_clzll(rest) + 1);
+        if (rank > registers[index])
+            registers[index] = rank;
+    }
+
+    // Returns false (and changes nothing) if the precisions differ
+    bool merge(const HyperLogLog& other) {
+        if (other.bits != bits)
+            return false;
+        for (std::size_t i {0}; i < registers.size(); i++)
+            if (other.registers[i] > registers[i])
+                registers[i] = other.registers[i];
+        return true;
+    }
+
+    double estimate() const {
+        auto m = static_cast<double>(registers.size());
+        double sum {0.0};
+        std::size_t zeros {0};
+        for (auto rank : registers) {
+            sum += std::ldexp(1.0, -rank);
+            zeros += rank == 0;
+        }
+
+        double alpha {registers.size() == 16 ? 0.673
+                      : registers.size() == 32 ? 0.697
+                      : registers.size() == 64 ? 0.709
+                      : 0.7213 / (1.0 + 1.079 / m)};
+        double raw {alpha * m * m / sum};
+        // Few words leave many registers empty, and counting those (linear
+        // counting) is far more accurate there than the harmonic mean. With
+        // 64-bit hashes no correction is needed at the top end.
+        if (raw <= 2.5 * m && zeros > 0)
+            return m * std::log(m / static_cast<double>(zeros));
+        return raw;
+    }
+
+    // Standard error of estimate() relative to the true count
+    double relativeError() const { return 1.04 / std::sqrt(static_cast<double>(registers.size())); }
+
+    int precision() const { return bits; }
+    std::size_t memoryUsage() const { return registers.size(); }
+};
+
+// Sketch of the words in text, filled on threads threads (0 = one per core)
+// that each sketch one chunk and are merged at the end
+inline HyperLogLog sketchWordsParallel(std::string_view text, int precision, unsigned threads) {
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+    std::vector<std::string_view> chunks {splitAtLines(text, threads)};
+    std::vector<HyperLogLog> locals(chunks.size(), HyperLogLog{precision});
+    std::vector<std::thread> workers;
+
+    for (std::size_t i {1}; i < chunks.size(); i++) {
+        workers.emplace_back([&chunks, &locals, i]() {
+            forEachWord(chunks[i], [&locals, i](std::string_view word, int) {
+                locals[i].add(word);
+            });
+        });
+    }
+    forEachWord(chunks[0], [&locals](std::string_view word, int) {
+        locals[0].add(word);
+    });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    for (std::size_t i {1}; i < locals.size(); i++)
+        locals[0].merge(locals[i]);
+    return locals[0];
+}
+
+#endif //CPPNOTES_HYPERLOGLOG_H
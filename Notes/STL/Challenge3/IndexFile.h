@@ -0,0 +1,222 @@
+#ifndef CPPNOTES_INDEXFILE_H
+#define CPPNOTES_INDEXFILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include "MappedFile.h"
+#include "PostingList.h"
+
+// On-disk word -> lines index, laid out so it can be used straight from mmap.
+//
+//   IndexHeader                    magic, word count, section sizes
+//   IndexEntry[wordCount + 1]      per word offsets, plus an end sentinel
+//   vocabulary bytes               the words back to back, in ascending order
+//   posting bytes                  each word's PostingList encoding back to back
+//
+// Word i is vocabulary[entry[i].wordOffset, entry[i + 1].wordOffset) and its lines
+// are postings[entry[i].postingOffset, entry[i + 1].postingOffset). All integers
+// are written in the machine's byte order.
+
+struct IndexHeader {
+    char magic[8];
+    std::uint64_t wordCount;
+    std::uint64_t vocabularyBytes;
+    std::uint64_t postingBytes;
+};
+
+struct IndexEntry {
+    std::uint64_t wordOffset;
+    std::uint64_t postingOffset;
+    std::uint64_t lineCount;
+};
+
+constexpr char indexMagic[8] {'C', '3', 'I', 'N', 'D', 'E', 'X', '1'};
+
+// Collects words in ascending order and writes them out as an index file
+class IndexWriter {
+private:
+    std::vector<IndexEntry> entries;
+    std::vector<char> vocabulary;
+    std::vector<std::uint8_t> postings;
+
+public:
+    // word must sort after every word added before it
+    void add(std::string_view word, PostingView lines, std::uint64_t lineCount) {
+        entries.push_back({vocabulary.size(), postings.size(), lineCount});
+        vocabulary.insert(vocabulary.end(), word.begin(), word.end());
+        postings.insert(postings.end(), lines.data(), lines.data() + lines.byteSize());
+    }
+
+    void add(std::string_view word, const PostingList& lines) {
+        add(word, lines.view(), lines.size());
+    }
+
+    std::size_t size() const { return entries.size(); }
+
+    // Returns false if the file could not be written
+    bool write(const std::string& path) const {
+        std::ofstream outFile {path, std::ios::binary | std::ios::trunc};
+        if (!outFile)
+            return false;
+
+        IndexHeader header {};
+        std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+        header.wordCount = entries.size();
+        header.vocabularyBytes = vocabulary.size();
+        header.postingBytes = postings.size();
+        IndexEntry sentinel {vocabulary.size(), postings.size(), 0};
+
+        outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        outFile.write(reinterpret_cast<const char*>(entries.data()),
+                      static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+        outFile.write(reinterpret_cast<const char*>(&sentinel), sizeof(sentinel));
+        outFile.write(vocabulary.data(), static_cast<std::streamsize>(vocabulary.size()));
+        outFile.write(reinterpret_cast<const char*>(postings.data()),
+                      static_cast<std::streamsize>(postings.size()));
+        return static_cast<bool>(outFile);
+    }
+};
+
+// Writes words (a WordPostings) to path, returns false on failure
+template <typename Map>
+bool writeIndex(const std::string& path, const Map& words) {
+    IndexWriter writer;
+    for (const auto& pair : words)
+        writer.add(pair.first, pair.second);
+    return writer.write(path);
+}
+
+// A loaded index file. Loading maps the file, checks the header, makes one
+// pass over the entries to check that every offset stays inside its section
+// and one over the postings to check that they decode to the line counts the
+// entries give, so a damaged file fails to load rather than misbehaving later.
+// Lookups binary search the mapped vocabulary and hand back views into it, so
+// nothing is allocated per query.
+class IndexView {
+private:
+    MappedFile file;
+    const IndexEntry* entries {nullptr};
+    const char* vocabulary {nullptr};
+    const std::uint8_t* postings {nullptr};
+    std::size_t words {0};
+    bool valid {false};
+
+    // Whether postings[begin, end) decodes to exactly lineCount ascending
+    // line numbers that fit in an int, each gap a varint of at most
+    // maxVarintBytes bytes. The list must end on the last byte of a varint, so
+    // decoding it can never run on past it.
+    bool checkPostings(std::uint64_t begin, std::uint64_t end, std::uint64_t lineCount) const {
+        std::uint64_t lines {0};
+        std::uint64_t line {0};
+        std::uint64_t i {begin};
+        while (i < end) {
+            std::uint64_t gap {0};
+            std::size_t length {0};
+            while (true) {
+                if (i == end || length == maxVarintBytes)
+                    return false;
+                std::uint8_t byte {postings[i++]};
+                gap |= static_cast<std::uint64_t>(byte & 0x7f) << (7 * length++);
+                if ((byte & 0x80) == 0)
+                    break;
+            }
+            if (gap == 0 || gap > static_cast<std::uint64_t>(std::numeric_limits<int>::max()) - line)
+                return false;
+            line += gap;
+            lines++;
+        }
+        return lines == lineCount;
+    }
+
+    // Offsets must never go backwards, the sentinel must end both sections
+    // exactly, so every word and posting list lies inside the file, and every
+    // posting list must decode cleanly
+    bool checkEntries(const IndexHeader& header) const {
+        for (std::size_t i {0}; i < words; i++) {
+            if (entries[i].wordOffset > entries[i + 1].wordOffset
+                || entries[i].postingOffset > entries[i + 1].postingOffset)
+                return false;
+        }
+        if (entries[0].wordOffset != 0 || entries[0].postingOffset != 0
+            || entries[words].wordOffset != header.vocabularyBytes
+            || entries[words].postingOffset != header.postingBytes)
+            return false;
+        for (std::size_t i {0}; i < words; i++)
+            if (!checkPostings(entries[i].postingOffset, entries[i + 1].postingOffset, entries[i].lineCount))
+                return false;
+        return true;
+    }
+
+public:
+    IndexView() = default;
+
+    explicit IndexView(const std::string& path) : file{path} {
+        std::string_view bytes {file.view()};
+        if (!file || bytes.size() < sizeof(IndexHeader))
+            return;
+
+        IndexHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0)
+            return;
+
+        // Each section is taken out of what is left of the file, so a huge
+        // count in a damaged header fails here instead of overflowing a sum
+        std::uint64_t left {bytes.size() - sizeof(IndexHeader)};
+        if (header.wordCount >= left / sizeof(IndexEntry))
+            return;
+        left -= (header.wordCount + 1) * sizeof(IndexEntry);
+        if (header.vocabularyBytes > left || header.postingBytes != left - header.vocabularyBytes)
+            return;
+
+        words = static_cast<std::size_t>(header.wordCount);
+        entries = reinterpret_cast<const IndexEntry*>(bytes.data() + sizeof(IndexHeader));
+        vocabulary = reinterpret_cast<const char*>(entries + words + 1);
+        postings = reinterpret_cast<const std::uint8_t*>(vocabulary + header.vocabularyBytes);
+        valid = checkEntries(header);
+        if (!valid)
+            words = 0;
+    }
+
+    explicit operator bool() const { return valid; }
+    std::size_t size() const { return words; }
+
+    std::string_view word(std::size_t i) const {
+        return {vocabulary + entries[i].wordOffset,
+                static_cast<std::size_t>(entries[i + 1].wordOffset - entries[i].wordOffset)};
+    }
+
+    PostingView lines(std::size_t i) const {
+        return {postings + entries[i].postingOffset, postings + entries[i + 1].postingOffset};
+    }
+
+    std::size_t lineCount(std::size_t i) const { return static_cast<std::size_t>(entries[i].lineCount); }
+
+    // Position of word in the vocabulary, or size() if it is not there
+    std::size_t find(std::string_view target) const {
+        std::size_t low {0};
+        std::size_t high {words};
+        while (low < high) {
+            std::size_t middle {low + (high - low) / 2};
+            if (word(middle) < target)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low < words && word(low) == target ? low : words;
+    }
+
+    // Lines of word, an empty view if it is not in the index
+    PostingView lookup(std::string_view target) const {
+        std::size_t i {find(target)};
+        return i < words ? lines(i) : PostingView{};
+    }
+};
+
+#endif //CPPNOTES_INDEXFILE_H
@@ -0,0 +1,89 @@
+#ifndef CPPNOTES_LINEINDEX_H
+#define CPPNOTES_LINEINDEX_H
+
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+// Where every line of a text starts, so line n can be handed back as a view
+// into the (usually memory mapped) text in O(1) instead of reading the text
+// again from the top with getline().
+//
+// Lines are numbered from 1 the way forEachWord() and part 2 number them. The
+// start of each line is kept as the low 32 bits of its byte offset, 4 bytes a
+// line; wraps records the lines where the offset crosses a 4 GB boundary, and
+// is empty for any smaller text.
+class LineIndex {
+private:
+    std::string_view text;
+    // Start of line n is starts[n - 1]. One extra entry marks where the line
+    // after the last one would start, so every line ends 1 byte before the
+    // next one starts.
+    std::vector<std::uint32_t> starts;
+    std::vector<std::uint32_t> wraps;
+
+    std::uint64_t offset(std::size_t i) const {
+        auto wrapped = static_cast<std::uint64_t>(std::upper_bound(wraps.begin(), wraps.end(), i) - wraps.begin());
+        return (wrapped << 32) | starts[i];
+    }
+
+    void addStart(std::uint64_t start) {
+        std::uint64_t previous {starts.empty() ? 0 : offset(starts.size() - 1)};
+        for (std::uint64_t high {previous >> 32}; high < start >> 32; high++)
+            wraps.push_back(static_cast<std::uint32_t>(starts.size()));
+        starts.push_back(static_cast<std::uint32_t>(start));
+    }
+
+public:
+    LineIndex() = default;
+
+    // The index keeps a view of text, which must outlive it
+    explicit LineIndex(std::string_view text) : text{text} {
+        starts.reserve(text.size() / 48 + 2);
+        addStart(0);
+        for (const char* p {text.data()}, *end {text.data() + text.size()}; p < end; p++) {
+            p = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (p == nullptr)
+                break;
+            addStart(static_cast<std::uint64_t>(p - text.data()) + 1);
+        }
+        // A last line without a newline still counts, as it does for getline()
+        if (offset(starts.size() - 1) < text.size())
+            addStart(text.size() + 1);
+        starts.shrink_to_fit();
+    }
+
+    // Number of lines
+    std::size_t size() const { return starts.empty() ? 0 : starts.size() - 1; }
+
+    // Line n without its "\n" or "\r\n", empty if there is no line n
+    std::string_view getLine(int n) const {
+        if (n < 1 || static_cast<std::size_t>(n) > size())
+            return {};
+        std::uint64_t begin {offset(static_cast<std::size_t>(n) - 1)};
+        std::uint64_t end {offset(static_cast<std::size_t>(n)) - 1};
+        std::string_view line {text.data() + begin, static_cast<std::size_t>(end - begin)};
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
+
+    // getLine() of every line in lines (a std::set<int>, PostingList, LineList ...)
+    template <typename Lines>
+    std::vector<std::string_view> getLines(const Lines& lines) const {
+        std::vector<std::string_view> views;
+        for (int n : lines)
+            views.push_back(getLine(n));
+        return views;
+    }
+
+    // Approximate heap footprint in bytes
+    std::size_t memoryUsage() const {
+        return (starts.capacity() + wraps.capacity()) * sizeof(std::uint32_t);
+    }
+};
+
+#endif //CPPNOTES_LINEINDEX_H
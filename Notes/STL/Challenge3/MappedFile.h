@@ -0,0 +1,87 @@
+#ifndef CPPNOTES_MAPPEDFILE_H
+#define CPPNOTES_MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file.
+// Like std::ifstream it converts to false if the file could not be opened,
+// and the mapping is released when the object goes out of scope.
+class MappedFile {
+private:
+    const char* data {nullptr};
+    std::size_t length {0};
+    bool opened {false};
+
+    void release() {
+        if (data != nullptr)
+            munmap(const_cast<char*>(data), length);
+        data = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path) {
+        int fd {open(path.c_str(), O_RDONLY)};
+        if (fd < 0)
+            return;
+
+        struct stat info {};
+        if (fstat(fd, &info) == 0) {
+            length = static_cast<std::size_t>(info.st_size);
+
+            // mmap() refuses zero length mappings, an empty file is just an empty view
+            if (length == 0)
+                opened = true;
+            else {
+                void* mapped {mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0)};
+                if (mapped != MAP_FAILED) {
+                    data = static_cast<const char*>(mapped);
+                    opened = true;
+                    madvise(mapped, length, MADV_SEQUENTIAL);
+                } else
+                    length = 0;
+            }
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : data{other.data}, length{other.length}, opened{other.opened} {
+        other.data = nullptr;
+        other.length = 0;
+        other.opened = false;
+    }
+
+    MappedFile& operator=(MappedFile&& rhs) noexcept {
+        if (this != &rhs) {
+            release();
+            data = rhs.data;
+            length = rhs.length;
+            opened = rhs.opened;
+            rhs.data = nullptr;
+            rhs.length = 0;
+            rhs.opened = false;
+        }
+        return *this;
+    }
+
+    ~MappedFile() { release(); }
+
+    explicit operator bool() const { return opened; }
+    std::size_t size() const { return length; }
+    std::string_view view() const { return {data, length}; }
+};
+
+#endif //CPPNOTES_MAPPEDFILE_H
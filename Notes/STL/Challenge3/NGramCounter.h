@@ -0,0 +1,261 @@
+#ifndef CPPNOTES_NGRAMCOUNTER_H
+#define CPPNOTES_NGRAMCOUNTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "WordHash.h"
+#include "Tokenizer.h"
+#include "WordDictionary.h"
+
+// Counts n-grams (runs of n adjacent words: pairs, triples, ...) of a word
+// stream in bounded memory: the table holds at most capacity n-grams and the
+// dictionary only the words they use. Words run on across line breaks, the way
+// the text reads.
+//
+// Every word is interned once in a WordDictionary, and an n-gram is just its
+// n word IDs. A polynomial hash over the last n IDs is rolled along the stream
+// (multiply in the new ID, subtract the one that fell out of the window), so
+// each word costs one dictionary lookup and one probe of an open addressing
+// table, however big n is. The table keeps the IDs of each n-gram next to its
+// count, so two n-grams that share a hash are still told apart, and the words
+// are only spelled out for the report.
+//
+// When the table holds capacity n-grams, the rarer half is pruned (lossy
+// counting): every n-gram whose count could be at most some floor is dropped,
+// and the floor is remembered. An n-gram that comes back afterwards may have
+// been dropped before, so its count can be low by up to the floor at the time
+// it came back, which is kept as its error. Any n-gram that is not in the
+// table at the end occurred at most floor() times. Each prune also re-interns
+// just the words that the surviving n-grams (and the window) still use, so a
+// long tail of rare words is dropped from the dictionary along with them;
+// the IDs change, so the hashes are worked out again at the same time.
+class NGramCounter {
+private:
+    static constexpr std::uint64_t base {0x9e3779b97f4a7c15};
+    static constexpr std::uint64_t empty {0};
+
+    // count and error are 64-bit so that no count can wrap round to the 0
+    // that marks an empty slot
+    struct Slot {
+        std::uint64_t hash;
+        std::uint64_t count;            // 0 marks an empty slot
+        std::uint64_t error;
+    };
+
+    int n;
+    std::size_t capacity;
+    WordDictionary words;
+
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> ids;     // n IDs per slot, slot i at ids[i * n]
+    std::size_t mask {0};
+    std::size_t used {0};
+    std::uint64_t floorCount {0};
+
+    std::vector<std::uint32_t> window;  // last n IDs, oldest at window[head]
+    std::size_t head {0};
+    std::size_t filled {0};
+    std::uint64_t rolling {0};
+    std::uint64_t baseToN {1};          // base^n, to take the oldest ID back out
+    std::uint64_t seen {0};
+
+    bool sameIds(std::size_t slot) const {
+        const std::uint32_t* stored {ids.data() + slot * static_cast<std::size_t>(n)};
+        for (std::size_t i {0}; i < static_cast<std::size_t>(n); i++)
+            if (stored[i] != window[(head + i) % static_cast<std::size_t>(n)])
+                return false;
+        return true;
+    }
+
+    // Slot holding the n-gram in the window, or the empty slot where it goes
+    std::size_t probe(std::uint64_t hash) const {
+        std::size_t i {mixHash(hash) & mask};
+        while (slots[i].count != empty && (slots[i].hash != hash || !sameIds(i)))
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    // Puts an n-gram back into a freshly cleared table
+    void reinsert(const Slot& slot, const std::uint32_t* gramIds) {
+        std::size_t i {mixHash(slot.hash) & mask};
+        while (slots[i].count != empty)
+            i = (i + 1) & mask;
+        slots[i] = slot;
+        std::copy(gramIds, gramIds + n, ids.begin() + static_cast<std::ptrdiff_t>(i * n));
+        used++;
+    }
+
+    // Moves everything in keptSlots / keptIds into a cleared table of size slots
+    void rebuild(std::size_t size, const std::vector<Slot>& keptSlots, const std::vector<std::uint32_t>& keptIds) {
+        slots.assign(size, Slot{0, empty, 0});
+        ids.assign(size * static_cast<std::size_t>(n), 0);
+        mask = size - 1;
+        used = 0;
+        for (std::size_t i {0}; i < keptSlots.size(); i++)
+            reinsert(keptSlots[i], keptIds.data() + i * static_cast<std::size_t>(n));
+    }
+
+    // Rebuilds the table, with only the n-grams keep() is true for
+    template <typename Keep>
+    void rebuild(std::size_t size, Keep keep) {
+        std::vector<Slot> keptSlots;
+        std::vector<std::uint32_t> keptIds;
+        for (std::size_t i {0}; i < slots.size(); i++) {
+            if (slots[i].count != empty && keep(slots[i])) {
+                keptSlots.push_back(slots[i]);
+                keptIds.insert(keptIds.end(), ids.begin() + static_cast<std::ptrdiff_t>(i * n),
+                               ids.begin() + static_cast<std::ptrdiff_t>((i + 1) * n));
+            }
+        }
+        rebuild(size, keptSlots, keptIds);
+    }
+
+    // Drops (at least) the rarer half, raises the floor to match and shrinks
+    // the dictionary to the words still in use
+    void prune() {
+        std::vector<std::uint64_t> bounds;
+        bounds.reserve(used);
+        for (const auto& slot : slots)
+            if (slot.count != empty)
+                bounds.push_back(slot.count + slot.error);
+        auto middle = bounds.begin() + static_cast<std::ptrdiff_t>(bounds.size() / 2);
+        std::nth_element(bounds.begin(), middle, bounds.end());
+        floorCount = std::max(floorCount, *middle);
+
+        WordDictionary kept;
+        std::vector<std::uint32_t> renumbered(words.size(), WordDictionary::none);
+        auto renumber = [this, &kept, &renumbered](std::uint32_t id) {
+            if (renumbered[id] == WordDictionary::none)
+                renumbered[id] = kept.intern(words.word(id));
+            return renumbered[id];
+        };
+
+        std::vector<Slot> keptSlots;
+        std::vector<std::uint32_t> keptIds;
+        for (std::size_t i {0}; i < slots.size(); i++) {
+            if (slots[i].count == empty || slots[i].count + slots[i].error <= floorCount)
+                continue;
+            std::uint64_t hash {0};
+            for (std::size_t j {0}; j < static_cast<std::size_t>(n); j++) {
+                std::uint32_t id {renumber(ids[i * static_cast<std::size_t>(n) + j])};
+                keptIds.push_back(id);
+                hash = hash * base + (id + 1);
+            }
+            keptSlots.push_back({hash, slots[i].count, slots[i].error});
+        }
+        rolling = 0;
+        for (std::size_t j {0}; j < filled; j++) {
+            std::uint32_t& id {window[(head + j) % static_cast<std::size_t>(n)]};
+            id = renumber(id);
+            rolling = rolling * base + (id + 1);
+        }
+        words = std::move(kept);
+        rebuild(slots.size(), keptSlots, keptIds);
+    }
+
+public:
+    struct Entry {
+        std::string words;              // the n words, space separated
+        std::uint64_t count;
+        std::uint64_t error;            // the true count is at most count + error
+    };
+
+    static constexpr int maxN {8};
+    static constexpr std::size_t minCapacity {16};
+
+    // Counts n-grams of n words (1 - maxN), keeping at most capacity (at least
+    // minCapacity) of them. Callers should check both ranges: values outside
+    // them are clamped. The table starts small and grows up to what capacity
+    // needs.
+    explicit NGramCounter(int n, std::size_t capacity = 1 << 20)
+        : n{std::clamp(n, 1, maxN)}, capacity{std::max(capacity, minCapacity)},
+          window(static_cast<std::size_t>(this->n), 0) {
+        rebuild(1024, {}, {});
+        for (int i {0}; i < this->n; i++)
+            baseToN *= base;
+    }
+
+    void add(std::string_view word) {
+        std::uint32_t id {words.intern(word)};
+        // IDs go in as ID + 1 so that a run of word 0 still changes the hash
+        if (filled == static_cast<std::size_t>(n)) {
+            rolling = rolling * base + (id + 1) - (window[head] + std::uint64_t{1}) * baseToN;
+            window[head] = id;
+            head = (head + 1) % static_cast<std::size_t>(n);
+        } else {
+            rolling = rolling * base + (id + 1);
+            window[filled++] = id;
+            if (filled < static_cast<std::size_t>(n))
+                return;
+        }
+        seen++;
+
+        std::size_t i {probe(rolling)};
+        if (slots[i].count != empty) {
+            slots[i].count++;
+            return;
+        }
+        slots[i] = {rolling, 1, floorCount};
+        for (std::size_t j {0}; j < static_cast<std::size_t>(n); j++)
+            ids[i * static_cast<std::size_t>(n) + j] = window[(head + j) % static_cast<std::size_t>(n)];
+        if (++used >= capacity)
+            prune();
+        else if (used * 10 > slots.size() * 7)     // keep the load factor under 70%
+            rebuild(slots.size() * 2, [](const Slot&) { return true; });
+    }
+
+    void addText(std::string_view text) {
+        forEachWord(text, [this](std::string_view word, int) {
+            add(word);
+        });
+    }
+
+    // The k most frequent n-grams (all of them if k is 0), most frequent
+    // first and alphabetical within a count
+    std::vector<Entry> top(std::size_t k = 0) const {
+        std::vector<std::size_t> live;
+        for (std::size_t i {0}; i < slots.size(); i++)
+            if (slots[i].count != empty)
+                live.push_back(i);
+
+        std::vector<Entry> entries;
+        entries.reserve(live.size());
+        for (auto i : live) {
+            std::string text;
+            for (std::size_t j {0}; j < static_cast<std::size_t>(n); j++) {
+                if (j > 0)
+                    text += ' ';
+                text += words.word(ids[i * static_cast<std::size_t>(n) + j]);
+            }
+            entries.push_back({std::move(text), slots[i].count, slots[i].error});
+        }
+        auto before = [](const Entry& lhs, const Entry& rhs) {
+            return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.words < rhs.words;
+        };
+        if (k > 0 && k < entries.size()) {
+            std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(k), entries.end(), before);
+            entries.resize(k);
+        } else
+            std::sort(entries.begin(), entries.end(), before);
+        return entries;
+    }
+
+    // n-grams in the stream so far
+    std::uint64_t streamSize() const { return seen; }
+    // n-grams being counted now
+    std::size_t size() const { return used; }
+    // No n-gram missing from top() occurred more often than this
+    std::uint64_t floor() const { return floorCount; }
+    int order() const { return n; }
+
+    // Approximate heap footprint in bytes, dictionary included
+    std::size_t memoryUsage() const {
+        return words.memoryUsage() + slots.capacity() * sizeof(Slot) + ids.capacity() * sizeof(std::uint32_t);
+    }
+};
+
+#endif //CPPNOTES_NGRAMCOUNTER_H
@@ -0,0 +1,84 @@
+#ifndef CPPNOTES_PARALLELCOUNT_H
+#define CPPNOTES_PARALLELCOUNT_H
+
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <cstddef>
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "StopWords.h"
+
+// Splits text into at most n chunks of roughly equal size. Every chunk apart
+// from the last ends just after a '\n', so no word is cut in two.
+inline std::vector<std::string_view> splitAtLines(std::string_view text, std::size_t n) {
+    std::vector<std::string_view> chunks;
+    if (n == 0)
+        n = 1;
+
+    std::size_t begin {0};
+    for (std::size_t i {1}; i < n && begin < text.size(); i++) {
+        std::size_t target {text.size() / n * i};
+        if (target < begin)
+            target = begin;
+
+        std::size_t newline {text.find('\n', target)};
+        if (newline == std::string_view::npos)
+            break;
+        chunks.push_back(text.substr(begin, newline + 1 - begin));
+        begin = newline + 1;
+    }
+    if (begin < text.size() || chunks.empty())
+        chunks.push_back(text.substr(begin));
+    return chunks;
+}
+
+// Folds the counts of from into into. Both maps are sorted, so walking them
+// together and inserting with a hint keeps the merge linear.
+inline void mergeCounts(WordCounts& into, const WordCounts& from) {
+    auto iter = into.begin();
+    for (const auto& pair : from) {
+        while (iter != into.end() && iter->first < pair.first)
+            ++iter;
+        if (iter == into.end() || iter->first != pair.first)
+            iter = into.emplace_hint(iter, pair.first, 0);
+        iter->second += pair.second;
+    }
+}
+
+// Counts the words of text on threads threads (0 = one per core). Every thread
+// fills its own map from its own chunk, so they never share anything until the
+// final merge, which gives exactly the map a single pass would have built.
+// Stopwords are left out if skipStopWords is set.
+inline WordCounts countWordsParallel(std::string_view text, unsigned threads, bool skipStopWords = false) {
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+    std::vector<std::string_view> chunks {splitAtLines(text, threads)};
+    std::vector<WordCounts> locals(chunks.size());
+    std::vector<std::thread> workers;
+
+    for (std::size_t i {1}; i < chunks.size(); i++) {
+        workers.emplace_back([&chunks, &locals, i, skipStopWords]() {
+            forEachWord(chunks[i], [&locals, i, skipStopWords](std::string_view word, int) {
+                if (!skipStopWords || !isStopWord(word))
+                    addWord(locals[i], word);
+            });
+        });
+    }
+    // The calling thread takes the first chunk instead of sitting idle
+    forEachWord(chunks[0], [&locals, skipStopWords](std::string_view word, int) {
+        if (!skipStopWords || !isStopWord(word))
+            addWord(locals[0], word);
+    });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    WordCounts words {std::move(locals[0])};
+    for (std::size_t i {1}; i < locals.size(); i++)
+        mergeCounts(words, locals[i]);
+    return words;
+}
+
+#endif //CPPNOTES_PARALLELCOUNT_H
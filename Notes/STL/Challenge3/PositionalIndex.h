@@ -0,0 +1,244 @@
+#ifndef CPPNOTES_POSITIONALINDEX_H
+#define CPPNOTES_POSITIONALINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "PostingList.h"
+
+// Ascending token positions of one word, stored as varint gaps like PostingList.
+// Every blockSize positions the byte offset and the last position of the block
+// are kept as a skip entry, so a Cursor can jump over whole blocks without
+// decoding them.
+class PositionList {
+private:
+    static constexpr std::size_t blockSize {128};
+
+    std::vector<std::uint8_t> bytes;
+    std::vector<std::uint64_t> offsets;     // block k starts at bytes[offsets[k]]
+    std::vector<std::uint64_t> lasts;       // last position in block k
+    std::uint64_t last {0};
+    std::size_t count {0};
+
+public:
+    // Walks the positions in order, decoding only the blocks it stops in
+    class Cursor {
+    private:
+        const PositionList* list;
+        std::size_t block {0};
+        std::size_t left {0};           // positions still to decode in the block
+        const std::uint8_t* p {nullptr};
+
+        void enter(std::size_t k) {
+            block = k;
+            position = k == 0 ? 0 : list->lasts[k - 1];
+            p = list->bytes.data() + list->offsets[k];
+            left = std::min(blockSize, list->count - k * blockSize);
+        }
+
+    public:
+        static constexpr std::uint64_t end {~std::uint64_t{0}};
+        std::uint64_t position {0};
+
+        explicit Cursor(const PositionList& list) : list{&list} {
+            if (list.count == 0)
+                position = end;
+            else {
+                enter(0);
+                next();
+            }
+        }
+
+        void next() {
+            if (left == 0) {
+                if (block + 1 == list->offsets.size()) {
+                    position = end;
+                    return;
+                }
+                enter(block + 1);
+            }
+            std::uint64_t delta;
+            p = getVarint(p, delta);
+            position += delta;
+            left--;
+        }
+
+        // Moves to the first position at or after target. The blocks to skip
+        // are galloped over, so a far seek costs a few lookups in lasts.
+        void seek(std::uint64_t target) {
+            if (position >= target)
+                return;
+            const auto& lasts = list->lasts;
+            if (lasts[block] < target) {
+                // Gallop to a range of blocks that ends past target, then
+                // binary search it for the first block that reaches target
+                std::size_t low {block + 1};
+                std::size_t high {low};
+                for (std::size_t step {1}; high < lasts.size() && lasts[high] < target; step *= 2) {
+                    low = high + 1;
+                    high += step;
+                }
+                auto found = std::lower_bound(lasts.begin() + static_cast<std::ptrdiff_t>(low),
+                                              lasts.begin() + static_cast<std::ptrdiff_t>(std::min(high + 1, lasts.size())),
+                                              target);
+                if (found == lasts.end()) {
+                    position = end;
+                    return;
+                }
+                enter(static_cast<std::size_t>(found - lasts.begin()));
+                next();
+            }
+            while (position < target)
+                next();
+        }
+    };
+
+    void append(std::uint64_t position) {
+        if (count % blockSize == 0) {
+            offsets.push_back(bytes.size());
+            lasts.push_back(position);
+        }
+        putVarint(bytes, position - last);
+        last = position;
+        lasts.back() = position;
+        count++;
+    }
+
+    Cursor cursor() const { return Cursor{*this}; }
+    std::size_t size() const { return count; }
+    std::size_t byteSize() const {
+        return bytes.capacity() + (offsets.capacity() + lasts.capacity()) * sizeof(std::uint64_t);
+    }
+};
+
+// Positional index for phrase queries.
+//
+// Every token gets a position counted across the whole text, so a phrase can
+// run over a line break. Each word keeps the positions it occurs at as varint
+// gaps (a byte or two for common words), and the line a position belongs to
+// is not stored per occurrence at all: the index keeps the first position of
+// every line once, as a 64-bit base for every 64 lines plus a 32-bit offset
+// per line, and finds a position's line by binary search.
+class PositionalIndex {
+private:
+    std::map<std::string, PositionList, std::less<>> words;
+    std::vector<std::uint64_t> blockBases;      // first position of lines 64k + 1
+    std::vector<std::uint32_t> lineOffsets;     // first position of each line - its block base
+    std::uint64_t tokens {0};
+    int firstLine {1};
+
+    std::uint64_t lineStart(std::size_t i) const { return blockBases[i / 64] + lineOffsets[i]; }
+
+    void startLines(int upTo) {
+        while (firstLine + static_cast<int>(lineOffsets.size()) <= upTo) {
+            if (lineOffsets.size() % 64 == 0)
+                blockBases.push_back(tokens);
+            lineOffsets.push_back(static_cast<std::uint32_t>(tokens - blockBases.back()));
+        }
+    }
+
+    // Positions at which the whole phrase starts. One cursor per term is
+    // leapfrogged: a candidate start is checked against the rarest term
+    // first, and a term that is not where the candidate needs it moves the
+    // candidate on to where it next could be, so each list is only decoded
+    // around the places the rarer terms point at.
+    std::vector<std::uint64_t> phraseStarts(const std::vector<std::string>& terms) const {
+        std::vector<std::pair<const PositionList*, std::uint64_t>> lists;     // list, offset in the phrase
+        for (std::size_t i {0}; i < terms.size(); i++) {
+            auto iter = words.find(terms[i]);
+            if (iter == words.end())
+                return {};
+            lists.emplace_back(&iter->second, i);
+        }
+        std::stable_sort(lists.begin(), lists.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first->size() < rhs.first->size();
+        });
+        std::vector<std::pair<PositionList::Cursor, std::uint64_t>> cursors;
+        for (const auto& [list, offset] : lists)
+            cursors.emplace_back(list->cursor(), offset);
+
+        std::vector<std::uint64_t> starts;
+        std::uint64_t candidate {0};
+        while (true) {
+            bool matched {true};
+            for (auto& [cursor, offset] : cursors) {
+                cursor.seek(candidate + offset);
+                if (cursor.position == PositionList::Cursor::end)
+                    return starts;
+                if (cursor.position != candidate + offset) {
+                    candidate = cursor.position - offset;
+                    matched = false;
+                    break;
+                }
+            }
+            if (matched)
+                starts.push_back(candidate++);
+        }
+    }
+
+public:
+    // Indexes text, whose first line is numbered firstLine. Call it once.
+    void build(std::string_view text, int firstLine = 1) {
+        this->firstLine = firstLine;
+        forEachWord(text, [this](std::string_view word, int line) {
+            startLines(line);
+            wordEntry(words, word).append(tokens++);
+        }, firstLine);
+    }
+
+    // Line the token at position is on
+    int lineOf(std::uint64_t position) const {
+        std::size_t low {0};
+        std::size_t high {lineOffsets.size()};
+        // Last line whose first position is <= position. A line without any
+        // words shares its start with the next line, so it is never picked.
+        while (high - low > 1) {
+            std::size_t middle {low + (high - low) / 2};
+            if (lineStart(middle) <= position)
+                low = middle;
+            else
+                high = middle;
+        }
+        return firstLine + static_cast<int>(low);
+    }
+
+    // Lines on which phrase starts, ascending and without repeats. The phrase
+    // is split and cleaned the same way the text was.
+    std::vector<int> findPhrase(std::string_view phrase) const {
+        std::vector<std::string> terms;
+        forEachWord(phrase, [&terms](std::string_view word, int) {
+            terms.emplace_back(word);
+        });
+        if (terms.empty())
+            return {};
+
+        std::vector<int> lines;
+        for (auto start : phraseStarts(terms)) {
+            int line {lineOf(start)};
+            if (lines.empty() || lines.back() != line)
+                lines.push_back(line);
+        }
+        return lines;
+    }
+
+    std::uint64_t tokenCount() const { return tokens; }
+
+    // Approximate heap footprint of the positions and line table in bytes
+    std::size_t memoryUsage() const {
+        std::size_t bytes {blockBases.capacity() * sizeof(std::uint64_t)
+                           + lineOffsets.capacity() * sizeof(std::uint32_t)};
+        for (const auto& pair : words)
+            bytes += pair.second.byteSize();
+        return bytes;
+    }
+};
+
+#endif //CPPNOTES_POSITIONALINDEX_H
@@ -0,0 +1,139 @@
+#ifndef CPPNOTES_POSTINGLIST_H
+#define CPPNOTES_POSTINGLIST_H
+
+#include <vector>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+
+// Appends value as a LEB128 varint: 7 bits per byte, high bit set on all but the last
+inline void putVarint(std::vector<std::uint8_t>& bytes, std::uint64_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+// Longest varint a 64-bit value needs
+constexpr std::size_t maxVarintBytes {10};
+
+// Reads one varint starting at p and returns the byte after it. Bits past the
+// 64th of an overlong varint are dropped rather than shifted out of range.
+inline const std::uint8_t* getVarint(const std::uint8_t* p, std::uint64_t& value) {
+    value = 0;
+    int shift {0};
+    while (*p & 0x80) {
+        if (shift < 64)
+            value |= static_cast<std::uint64_t>(*p & 0x7f) << shift;
+        p++;
+        shift += 7;
+    }
+    if (shift < 64)
+        value |= static_cast<std::uint64_t>(*p) << shift;
+    return p + 1;
+}
+
+// Decodes a run of delta encoded varints back into ascending line numbers
+class PostingIterator {
+private:
+    const std::uint8_t* current {nullptr};
+    const std::uint8_t* next {nullptr};
+    const std::uint8_t* end {nullptr};
+    int value {0};
+
+    void decode() {
+        if (current != end) {
+            std::uint64_t delta;
+            next = getVarint(current, delta);
+            value += static_cast<int>(delta);
+        }
+    }
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = const int&;
+
+    PostingIterator() = default;
+    PostingIterator(const std::uint8_t* begin, const std::uint8_t* end)
+        : current{begin}, next{begin}, end{end} { decode(); }
+
+    const int& operator*() const { return value; }
+    const int* operator->() const { return &value; }
+
+    PostingIterator& operator++() {
+        current = next;
+        decode();
+        return *this;
+    }
+
+    PostingIterator operator++(int) {
+        PostingIterator old {*this};
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const PostingIterator& rhs) const { return current == rhs.current; }
+    bool operator!=(const PostingIterator& rhs) const { return current != rhs.current; }
+};
+
+// Read-only view of encoded posting bytes owned by someone else
+class PostingView {
+private:
+    const std::uint8_t* first {nullptr};
+    const std::uint8_t* last {nullptr};
+
+public:
+    PostingView() = default;
+    PostingView(const std::uint8_t* first, const std::uint8_t* last) : first{first}, last{last} { }
+
+    PostingIterator begin() const { return {first, last}; }
+    PostingIterator end() const { return {last, last}; }
+    bool empty() const { return first == last; }
+    const std::uint8_t* data() const { return first; }
+    std::size_t byteSize() const { return static_cast<std::size_t>(last - first); }
+};
+
+// Ascending list of the line numbers a word appears on.
+// Lines arrive in increasing order, so each one is stored as the varint of its
+// gap from the previous one: usually a single byte, instead of the 32-48 byte
+// red-black tree node a std::set<int> pays per line. Appending the line that was
+// appended last is a no-op, the same way std::set ignores duplicates, but it
+// is still counted in totalOccurrences().
+class PostingList {
+private:
+    std::vector<std::uint8_t> bytes;
+    int last {0};
+    int lines {0};
+    int occurrences {0};
+
+public:
+    // Amortized O(1), line must be >= every line appended before it
+    void append(int line) {
+        occurrences++;
+        if (lines > 0 && line == last)
+            return;
+        putVarint(bytes, static_cast<std::uint64_t>(line - last));
+        last = line;
+        lines++;
+    }
+
+    PostingIterator begin() const { return {bytes.data(), bytes.data() + bytes.size()}; }
+    PostingIterator end() const { return {bytes.data() + bytes.size(), bytes.data() + bytes.size()}; }
+    PostingView view() const { return {bytes.data(), bytes.data() + bytes.size()}; }
+
+    // Number of distinct lines
+    std::size_t size() const { return static_cast<std::size_t>(lines); }
+    bool empty() const { return lines == 0; }
+    int back() const { return last; }
+    // Number of append() calls, repeated lines included: the word's part 1 count
+    int totalOccurrences() const { return occurrences; }
+
+    const std::vector<std::uint8_t>& encoded() const { return bytes; }
+    void shrinkToFit() { bytes.shrink_to_fit(); }
+};
+
+#endif //CPPNOTES_POSTINGLIST_H
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include "IndexFile.h"
+#include "QueryEngine.h"
+#include "SegmentStore.h"
+
+// Runs boolean / proximity queries (see QueryEngine.h) against an index saved
+// with "Challenge3 --save-index FILE", or across every segment of a store
+// built with "Challenge3 --add-segment DIR".
+//
+// Usage: Query FILE|DIR [query...]
+// With no queries on the command line they are read from stdin, one per line,
+// so a batch of thousands only pays for loading the index once.
+
+template <typename Index>
+int runQueries(const Index& index, int argc, char* argv[]);
+template <typename Index>
+void printResult(const std::string& query, QueryEngine<Index>& engine);
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: Query FILE|DIR [query...]" << std::endl;
+        return 1;
+    }
+
+    if (std::filesystem::is_directory(argv[1])) {
+        SegmentStore store {argv[1]};
+        if (!store) {
+            std::cerr << "\nError opening segment store!" << std::endl;
+            return 1;
+        }
+        return runQueries(store, argc, argv);
+    }
+
+    IndexView index {argv[1]};
+    if (!index) {
+        std::cerr << "\nError opening index file!" << std::endl;
+        return 1;
+    }
+    return runQueries(index, argc, argv);
+}
+
+template <typename Index>
+int runQueries(const Index& index, int argc, char* argv[]) {
+    QueryEngine<Index> engine {index};
+    if (argc > 2) {
+        for (int i {2}; i < argc; i++)
+            printResult(argv[i], engine);
+    } else {
+        std::string query;
+        while (getline(std::cin, query))
+            printResult(query, engine);
+    }
+    return 0;
+}
+
+template <typename Index>
+void printResult(const std::string& query, QueryEngine<Index>& engine) {
+    LineList lines;
+    if (!engine.run(query, lines)) {
+        std::cerr << query << ": " << engine.lastError() << "\n";
+        return;
+    }
+
+    std::cout << query << " [ ";
+    for (const auto& line : lines)
+        std::cout << line << " ";
+    std::cout << "]\n";
+}
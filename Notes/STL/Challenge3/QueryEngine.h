@@ -0,0 +1,267 @@
+#ifndef CPPNOTES_QUERYENGINE_H
+#define CPPNOTES_QUERYENGINE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cstddef>
+#include "IndexFile.h"
+#include "WordIndex.h"
+
+// Boolean and proximity queries over a word -> lines concordance.
+//
+//   Aunt Em                 lines with both words (AND is implied)
+//   Aunt AND Em             the same
+//   Henry OR Em             lines with either word
+//   Aunt NOT Em             lines with Aunt but not Em (also "Aunt AND NOT Em"
+//                           or "NOT Em Aunt")
+//   Aunt NEAR/3 Em          lines with Aunt or Em that have the other word
+//                           at most 3 lines away
+//   (Henry OR Em) AND Aunt  parentheses group
+//
+// Precedence from tightest to loosest is NEAR, NOT, AND, OR. NOT takes lines
+// away from the other words of its AND group, so a group made only of NOTs
+// ("NOT Em", "Aunt OR NOT Em") is an error: the index does not know every
+// line of the text, only the lines its words are on. Parentheses nest at most
+// maxDepth deep. The result is always an ascending list of line numbers.
+
+using LineList = std::vector<int>;
+
+// Index of the first element of lines[from, end) that is >= target.
+// Gallops (1, 2, 4, ...) and then binary searches the last step, so skipping k
+// elements costs O(log k) rather than O(k).
+inline std::size_t gallopTo(const LineList& lines, std::size_t from, int target) {
+    std::size_t step {1};
+    std::size_t high {from};
+    while (high < lines.size() && lines[high] < target) {
+        from = high + 1;
+        high += step;
+        step *= 2;
+    }
+    high = std::min(high, lines.size());
+    return static_cast<std::size_t>(std::lower_bound(lines.begin() + from, lines.begin() + high, target)
+                                    - lines.begin());
+}
+
+// Walks the shorter list and gallops through the longer one, so a rare word
+// AND a common word costs about |rare| * log(|common| / |rare|)
+inline LineList intersectLines(const LineList& lhs, const LineList& rhs) {
+    const LineList& small {lhs.size() <= rhs.size() ? lhs : rhs};
+    const LineList& large {lhs.size() <= rhs.size() ? rhs : lhs};
+    LineList result;
+    std::size_t j {0};
+    for (int line : small) {
+        j = gallopTo(large, j, line);
+        if (j == large.size())
+            break;
+        if (large[j] == line)
+            result.push_back(line);
+    }
+    return result;
+}
+
+inline LineList unionLines(const LineList& lhs, const LineList& rhs) {
+    LineList result;
+    result.reserve(lhs.size() + rhs.size());
+    std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(result));
+    return result;
+}
+
+// Lines of lhs that are not in rhs
+inline LineList subtractLines(const LineList& lhs, const LineList& rhs) {
+    LineList result;
+    std::size_t j {0};
+    for (int line : lhs) {
+        j = gallopTo(rhs, j, line);
+        if (j == rhs.size() || rhs[j] != line)
+            result.push_back(line);
+    }
+    return result;
+}
+
+// Lines of either list that have a line of the other list at most distance
+// away. The window is worked out in long long, so it cannot overflow.
+inline LineList nearLines(const LineList& lhs, const LineList& rhs, unsigned distance) {
+    auto keep = [distance](const LineList& from, const LineList& other, LineList& out) {
+        std::size_t j {0};
+        for (int line : from) {
+            long long low {std::max<long long>(static_cast<long long>(line) - distance, std::numeric_limits<int>::min())};
+            j = gallopTo(other, j, static_cast<int>(low));
+            if (j < other.size() && other[j] <= static_cast<long long>(line) + distance)
+                out.push_back(line);
+        }
+    };
+    LineList left;
+    LineList right;
+    keep(lhs, rhs, left);
+    keep(rhs, lhs, right);
+    return unionLines(left, right);
+}
+
+inline LineList lookupLines(const IndexView& index, std::string_view word) {
+    PostingView lines {index.lookup(word)};
+    return {lines.begin(), lines.end()};
+}
+
+inline LineList lookupLines(const WordPostings& words, std::string_view word) {
+    auto iter = words.find(word);
+    return iter == words.end() ? LineList{} : LineList{iter->second.begin(), iter->second.end()};
+}
+
+// Recursive descent parser that evaluates as it parses. Index is anything
+// lookupLines() has an overload for.
+template <typename Index>
+class QueryEngine {
+private:
+    const Index& index;
+    std::vector<std::string> tokens;
+    std::size_t next {0};
+    int depth {0};
+    std::string error;
+
+    void split(std::string_view query) {
+        tokens.clear();
+        std::string token;
+        for (char c : query) {
+            if (c == '(' || c == ')' || c == ' ' || c == '\t') {
+                if (!token.empty())
+                    tokens.push_back(token);
+                token.clear();
+                if (c == '(' || c == ')')
+                    tokens.emplace_back(1, c);
+            } else
+                token += c;
+        }
+        if (!token.empty())
+            tokens.push_back(token);
+    }
+
+    bool peek(const char* keyword) const { return next < tokens.size() && tokens[next] == keyword; }
+
+    // NEAR/k, with k clamped to maxDistance: no two lines are further apart
+    static bool isNear(const std::string& token, unsigned& distance) {
+        if (token.compare(0, 5, "NEAR/") != 0 || token.size() == 5)
+            return false;
+        distance = 0;
+        for (std::size_t i {5}; i < token.size(); i++) {
+            if (token[i] < '0' || token[i] > '9')
+                return false;
+            unsigned digit {static_cast<unsigned>(token[i] - '0')};
+            distance = distance > (maxDistance - digit) / 10 ? maxDistance : distance * 10 + digit;
+        }
+        return true;
+    }
+
+    bool startsOperand() const {
+        unsigned distance;
+        return next < tokens.size() && tokens[next] != ")" && tokens[next] != "AND" && tokens[next] != "OR"
+               && tokens[next] != "NOT" && !isNear(tokens[next], distance);
+    }
+
+    LineList parseOr() {
+        LineList lines {parseAnd()};
+        while (error.empty() && peek("OR")) {
+            next++;
+            lines = unionLines(lines, parseAnd());
+        }
+        return lines;
+    }
+
+    // The NOT terms of the group are collected and taken away once the other
+    // terms are intersected
+    LineList parseAnd() {
+        LineList lines;
+        std::vector<LineList> excluded;
+        bool positive {false};
+        bool first {true};
+        while (error.empty()) {
+            bool needed {first};
+            if (!first && peek("AND")) {
+                next++;
+                needed = true;
+            }
+            if (peek("NOT")) {
+                next++;
+                excluded.push_back(parseNear());
+            } else if (needed || startsOperand()) {
+                LineList term {parseNear()};
+                lines = positive ? intersectLines(lines, term) : std::move(term);
+                positive = true;
+            } else
+                break;
+            first = false;
+        }
+        if (error.empty() && !positive)
+            error = "NOT needs a word to take lines away from, e.g. \"Aunt NOT Em\"";
+        for (const auto& without : excluded)
+            lines = subtractLines(lines, without);
+        return lines;
+    }
+
+    LineList parseNear() {
+        LineList lines {parseOperand()};
+        unsigned distance;
+        while (error.empty() && next < tokens.size() && isNear(tokens[next], distance)) {
+            next++;
+            lines = nearLines(lines, parseOperand(), distance);
+        }
+        return lines;
+    }
+
+    LineList parseOperand() {
+        if (next >= tokens.size()) {
+            error = "query ends where a word was expected";
+            return {};
+        }
+        if (peek("(")) {
+            if (depth == maxDepth) {
+                error = "parentheses nested more than " + std::to_string(maxDepth) + " deep";
+                return {};
+            }
+            next++;
+            depth++;
+            LineList lines {parseOr()};
+            depth--;
+            if (!peek(")")) {
+                if (error.empty())
+                    error = "missing ')'";
+                return {};
+            }
+            next++;
+            return lines;
+        }
+        if (!startsOperand()) {
+            error = "unexpected '" + tokens[next] + "'";
+            return {};
+        }
+        return lookupLines(index, tokens[next++]);
+    }
+
+public:
+    static constexpr int maxDepth {256};
+    static constexpr unsigned maxDistance {static_cast<unsigned>(std::numeric_limits<int>::max())};
+
+    explicit QueryEngine(const Index& index) : index{index} { }
+
+    // Evaluates query into lines. On a syntax error returns false and
+    // lastError() says what was wrong.
+    bool run(std::string_view query, LineList& lines) {
+        split(query);
+        next = 0;
+        depth = 0;
+        error.clear();
+        lines = parseOr();
+        if (error.empty() && next < tokens.size())
+            error = "unexpected '" + tokens[next] + "'";
+        if (!error.empty())
+            lines.clear();
+        return error.empty();
+    }
+
+    const std::string& lastError() const { return error; }
+};
+
+#endif //CPPNOTES_QUERYENGINE_H
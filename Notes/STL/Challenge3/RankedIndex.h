@@ -0,0 +1,392 @@
+#ifndef CPPNOTES_RANKEDINDEX_H
+#define CPPNOTES_RANKEDINDEX_H
+
+#include <string_view>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include "Tokenizer.h"
+#include "PostingList.h"
+#include "WordDictionary.h"
+
+enum class Scoring {
+    bm25,       // Okapi BM25, k1 = 1.2, b = 0.75
+    tfIdf       // (1 + ln tf) * ln(N / df), no length normalisation
+};
+
+struct ScoredDocument {
+    std::uint32_t document;
+    double score;
+};
+
+// Best first: higher score, then the earlier document
+inline bool betterThan(const ScoredDocument& lhs, const ScoredDocument& rhs) {
+    return lhs.score != rhs.score ? lhs.score > rhs.score : lhs.document < rhs.document;
+}
+
+// Word -> (document, term frequency) index over many documents, answering
+// "the k documents that best match these words" under BM25 or TF-IDF.
+//
+// Documents are numbered 0, 1, 2, ... in the order they are added. Each word's
+// postings are (document gap, frequency) varint pairs cut into blocks of
+// blockSize, and every block remembers the last document in it, so a cursor can
+// skip a whole block without decoding it.
+//
+// search() is MaxScore: each word carries the highest score it gives any
+// document. Sorted by that bound, the weakest words whose bounds add up to no
+// more than the k-th best score so far cannot put a document in the top k on
+// their own, so only the documents of the other ("essential") words are
+// visited. The weak words are then looked up for a document with a skip
+// (strongest first), and only while they could still lift it into the top k.
+// As the top k fill up with good matches, common words drop out of the
+// essential set and most of their postings are skipped rather than scored.
+// searchExhaustive() scores every document that has any of the words, as a
+// reference; ties go to the earlier document in both.
+class RankedIndex {
+private:
+    static constexpr std::uint32_t blockSize {128};
+    static constexpr std::uint32_t end {0xffffffff};
+    static constexpr double k1 {1.2};
+    static constexpr double b {0.75};
+
+    struct Block {
+        std::uint32_t offset;           // into Term::bytes
+        std::uint32_t base;             // document the first gap is from
+        std::uint32_t last;             // last document in the block
+    };
+
+    struct Term {
+        std::vector<std::uint8_t> bytes;
+        std::vector<Block> blocks;
+        std::uint32_t documents {0};    // df
+        double maxScore[2] {0.0, 0.0};  // indexed by Scoring
+    };
+
+    // Walks one term's postings in document order
+    class Cursor {
+    private:
+        const Term* term;
+        std::size_t block {0};
+        std::uint32_t left {0};         // postings still to decode in the block
+        const std::uint8_t* p {nullptr};
+
+        void enter(std::size_t i) {
+            block = i;
+            doc = term->blocks[i].base;
+            p = term->bytes.data() + term->blocks[i].offset;
+            left = std::min(blockSize, term->documents - static_cast<std::uint32_t>(i) * blockSize);
+        }
+
+    public:
+        std::uint32_t doc {0};
+        std::uint32_t tf {0};
+        std::size_t termIndex;
+
+        Cursor(const Term& term, std::size_t termIndex) : term{&term}, termIndex{termIndex} {
+            enter(0);
+            next();
+        }
+
+        void next() {
+            if (left == 0) {
+                if (block + 1 == term->blocks.size()) {
+                    doc = end;
+                    return;
+                }
+                enter(block + 1);
+            }
+            std::uint64_t gap;
+            std::uint64_t frequency;
+            p = getVarint(getVarint(p, gap), frequency);
+            doc += static_cast<std::uint32_t>(gap);
+            tf = static_cast<std::uint32_t>(frequency);
+            left--;
+        }
+
+        // Moves to the first posting at or after target
+        void seek(std::uint32_t target) {
+            if (doc >= target)
+                return;
+            std::size_t i {block};
+            while (i < term->blocks.size() && term->blocks[i].last < target)
+                i++;
+            if (i == term->blocks.size()) {
+                doc = end;
+                return;
+            }
+            if (i != block) {
+                enter(i);
+                next();
+            }
+            while (doc < target)
+                next();
+        }
+    };
+
+    WordDictionary words;
+    std::vector<Term> terms;
+    std::vector<std::uint32_t> lengths;     // words per document
+    std::uint64_t totalLength {0};
+    double lengthWeight {0.0};              // k1 * b / average length, set by finish()
+    std::vector<std::uint32_t> scratch;
+
+    void append(std::uint32_t id, std::uint32_t document, std::uint32_t tf) {
+        Term& term {terms[id]};
+        if (term.documents % blockSize == 0) {
+            std::uint32_t base {term.blocks.empty() ? 0 : term.blocks.back().last};
+            term.blocks.push_back({static_cast<std::uint32_t>(term.bytes.size()), base, base});
+        }
+        putVarint(term.bytes, document - term.blocks.back().last);
+        putVarint(term.bytes, tf);
+        term.blocks.back().last = document;
+        term.documents++;
+    }
+
+    // Turns the word IDs in scratch into the next document's postings
+    void flushDocument() {
+        auto document = static_cast<std::uint32_t>(lengths.size());
+        lengths.push_back(static_cast<std::uint32_t>(scratch.size()));
+        totalLength += scratch.size();
+
+        std::sort(scratch.begin(), scratch.end());
+        for (std::size_t i {0}; i < scratch.size();) {
+            std::size_t j {i};
+            while (j < scratch.size() && scratch[j] == scratch[i])
+                j++;
+            append(scratch[i], document, static_cast<std::uint32_t>(j - i));
+            i = j;
+        }
+        scratch.clear();
+    }
+
+    void collect(std::string_view word) {
+        std::uint32_t id {words.intern(word)};
+        if (id == terms.size())
+            terms.emplace_back();
+        scratch.push_back(id);
+    }
+
+    double idf(const Term& term, Scoring scoring) const {
+        auto n = static_cast<double>(lengths.size());
+        auto df = static_cast<double>(term.documents);
+        if (scoring == Scoring::bm25)
+            return std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+        return std::log(n / df);
+    }
+
+    double termScore(double weight, std::uint32_t tf, std::uint32_t document, Scoring scoring) const {
+        if (scoring == Scoring::tfIdf)
+            return weight * (1.0 + std::log(static_cast<double>(tf)));
+        double norm {k1 * (1.0 - b) + lengthWeight * lengths[document]};
+        return weight * tf * (k1 + 1.0) / (tf + norm);
+    }
+
+    // Distinct known words of query, in the order they first appear
+    std::vector<std::uint32_t> queryTerms(std::string_view query) const {
+        std::vector<std::uint32_t> ids;
+        forEachWord(query, [this, &ids](std::string_view word, int) {
+            std::uint32_t id {words.find(word)};
+            if (id != WordDictionary::none && std::find(ids.begin(), ids.end(), id) == ids.end())
+                ids.push_back(id);
+        });
+        return ids;
+    }
+
+    // Keeps the k best documents seen, worst on top
+    class TopK {
+    private:
+        std::size_t k;
+        std::priority_queue<ScoredDocument, std::vector<ScoredDocument>, decltype(&betterThan)> heap {&betterThan};
+
+    public:
+        explicit TopK(std::size_t k) : k{k} { }
+
+        // Score a document must beat to get in, -1 while there is room
+        double threshold() const { return heap.size() < k ? -1.0 : heap.top().score; }
+
+        void offer(std::uint32_t document, double score) {
+            if (heap.size() < k)
+                heap.push({document, score});
+            else if (betterThan({document, score}, heap.top())) {
+                heap.pop();
+                heap.push({document, score});
+            }
+        }
+
+        std::vector<ScoredDocument> sorted() {
+            std::vector<ScoredDocument> best;
+            for (; !heap.empty(); heap.pop())
+                best.push_back(heap.top());
+            std::reverse(best.begin(), best.end());
+            return best;
+        }
+    };
+
+public:
+    // Adds text as one document and returns its number
+    std::uint32_t addDocument(std::string_view text) {
+        forEachWord(text, [this](std::string_view word, int) {
+            collect(word);
+        });
+        flushDocument();
+        return static_cast<std::uint32_t>(lengths.size() - 1);
+    }
+
+    // Adds every line of text as a document of its own, empty lines included,
+    // so line n of text is document firstDocument + n - 1. Returns firstDocument.
+    std::uint32_t addLines(std::string_view text) {
+        auto firstDocument = static_cast<std::uint32_t>(lengths.size());
+        int current {1};
+        forEachWord(text, [this, &current](std::string_view word, int line) {
+            for (; current < line; current++)
+                flushDocument();
+            collect(word);
+        });
+        int lines {static_cast<int>(std::count(text.begin(), text.end(), '\n'))};
+        if (!text.empty() && text.back() != '\n')
+            lines++;
+        for (; current <= lines; current++)
+            flushDocument();
+        return firstDocument;
+    }
+
+    // Works out every word's score bounds, call it after the last add
+    void finish() {
+        lengthWeight = averageLength() > 0.0 ? k1 * b / averageLength() : 0.0;
+        for (auto& term : terms) {
+            for (auto scoring : {Scoring::bm25, Scoring::tfIdf}) {
+                double weight {idf(term, scoring)};
+                double best {0.0};
+                for (Cursor cursor {term, 0}; cursor.doc != end; cursor.next())
+                    best = std::max(best, termScore(weight, cursor.tf, cursor.doc, scoring));
+                term.maxScore[static_cast<int>(scoring)] = best;
+            }
+        }
+    }
+
+    // The k best documents for the words of query, best first (MaxScore).
+    // scored, if given, is set to the number of documents fully scored.
+    std::vector<ScoredDocument> search(std::string_view query, std::size_t k, Scoring scoring = Scoring::bm25,
+                                       std::size_t* scored = nullptr) const {
+        std::vector<std::uint32_t> ids {queryTerms(query)};
+        std::vector<Cursor> cursors;
+        std::vector<double> weights;
+        for (std::size_t i {0}; i < ids.size(); i++) {
+            cursors.emplace_back(terms[ids[i]], i);
+            weights.push_back(idf(terms[ids[i]], scoring));
+        }
+
+        // Weakest word first, and below[i] is the most order[0, i) can add
+        auto bound = [this, &ids, scoring](const Cursor* cursor) {
+            return terms[ids[cursor->termIndex]].maxScore[static_cast<int>(scoring)];
+        };
+        std::vector<Cursor*> order;
+        for (auto& cursor : cursors)
+            order.push_back(&cursor);
+        std::sort(order.begin(), order.end(), [&bound](const Cursor* lhs, const Cursor* rhs) {
+            return bound(lhs) < bound(rhs);
+        });
+        std::vector<double> below {0.0};
+        for (const auto* cursor : order)
+            below.push_back(below.back() + bound(cursor));
+
+        TopK best {k};
+        std::size_t count {0};
+        std::size_t essential {0};          // order[essential, end) are essential
+        std::vector<double> parts(cursors.size());
+        while (k > 0) {
+            double threshold {best.threshold()};
+            while (essential < order.size() && below[essential + 1] <= threshold)
+                essential++;
+
+            std::uint32_t target {end};
+            for (std::size_t i {essential}; i < order.size(); i++)
+                target = std::min(target, order[i]->doc);
+            if (target == end)
+                break;
+
+            std::fill(parts.begin(), parts.end(), 0.0);
+            auto take = [&](Cursor& cursor) {
+                parts[cursor.termIndex] = termScore(weights[cursor.termIndex], cursor.tf, target, scoring);
+                return parts[cursor.termIndex];
+            };
+
+            double score {0.0};
+            for (std::size_t i {essential}; i < order.size(); i++) {
+                if (order[i]->doc == target) {
+                    score += take(*order[i]);
+                    order[i]->next();
+                }
+            }
+            bool possible {true};
+            for (std::size_t i {essential}; possible && i-- > 0;) {
+                possible = score + below[i + 1] > threshold;
+                if (possible) {
+                    order[i]->seek(target);
+                    if (order[i]->doc == target)
+                        score += take(*order[i]);
+                }
+            }
+
+            if (possible) {
+                // Added up again in query order, as searchExhaustive() does, so
+                // both get the same score to the last bit
+                score = 0.0;
+                for (double part : parts)
+                    score += part;
+                best.offer(target, score);
+                count++;
+            }
+        }
+
+        if (scored != nullptr)
+            *scored = count;
+        return best.sorted();
+    }
+
+    // The same results as search(), from scoring every document that has any of
+    // the words
+    std::vector<ScoredDocument> searchExhaustive(std::string_view query, std::size_t k,
+                                                 Scoring scoring = Scoring::bm25, std::size_t* scored = nullptr) const {
+        std::vector<double> scores(lengths.size(), 0.0);
+        std::vector<bool> seen(lengths.size(), false);
+        std::vector<std::uint32_t> touched;
+        for (auto id : queryTerms(query)) {
+            double weight {idf(terms[id], scoring)};
+            for (Cursor cursor {terms[id], 0}; cursor.doc != end; cursor.next()) {
+                if (!seen[cursor.doc]) {
+                    seen[cursor.doc] = true;
+                    touched.push_back(cursor.doc);
+                }
+                scores[cursor.doc] += termScore(weight, cursor.tf, cursor.doc, scoring);
+            }
+        }
+
+        TopK best {k};
+        for (auto document : touched)
+            best.offer(document, scores[document]);
+        if (scored != nullptr)
+            *scored = touched.size();
+        return best.sorted();
+    }
+
+    std::size_t size() const { return lengths.size(); }
+    std::size_t wordCount() const { return words.size(); }
+    double averageLength() const {
+        return lengths.empty() ? 0.0 : static_cast<double>(totalLength) / static_cast<double>(lengths.size());
+    }
+
+    // Approximate heap footprint in bytes
+    std::size_t memoryUsage() const {
+        std::size_t bytes {words.memoryUsage() + terms.capacity() * sizeof(Term)
+                           + lengths.capacity() * sizeof(std::uint32_t)};
+        for (const auto& term : terms)
+            bytes += term.bytes.capacity() + term.blocks.capacity() * sizeof(Block);
+        return bytes;
+    }
+};
+
+#endif //CPPNOTES_RANKEDINDEX_H
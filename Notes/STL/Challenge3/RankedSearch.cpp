@@ -0,0 +1,91 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+#include "MappedFile.h"
+#include "LineIndex.h"
+#include "DirectoryIndexer.h"
+#include "RankedIndex.h"
+
+// Ranked retrieval (see RankedIndex.h): the k documents that best match each
+// query, under BM25 or TF-IDF. Given a file, every line of it is a document;
+// given a directory, every file under it is.
+//
+// Usage: RankedSearch [--k K] [--tfidf] FILE|DIR [query...]
+// With no queries on the command line they are read from stdin, one per line,
+// so a batch only pays for building the index once.
+
+void printResults(const std::string& query, const RankedIndex& index, std::size_t k, Scoring scoring,
+                  const LineIndex& lines, const std::vector<std::string>& files);
+
+int main(int argc, char* argv[]) {
+    std::size_t k {10};
+    Scoring scoring {Scoring::bm25};
+    int i {1};
+    for (; i < argc; i++) {
+        if (std::strcmp(argv[i], "--k") == 0 && i + 1 < argc)
+            k = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--tfidf") == 0)
+            scoring = Scoring::tfIdf;
+        else
+            break;
+    }
+    if (i == argc) {
+        std::cerr << "Usage: RankedSearch [--k K] [--tfidf] FILE|DIR [query...]" << std::endl;
+        return 1;
+    }
+
+    RankedIndex index;
+    MappedFile inFile;
+    LineIndex lines;
+    std::vector<std::string> files;
+    if (std::filesystem::is_directory(argv[i])) {
+        std::vector<std::string> errors;
+        files = listFiles(argv[i], errors);
+        for (const auto& error : errors)
+            std::cerr << "\nError reading " << error << "!" << std::endl;
+        for (const auto& file : files) {
+            // An unreadable file still takes its document number, with no words
+            MappedFile document {file};
+            if (!document)
+                std::cerr << "\nError opening input file " << file << "!" << std::endl;
+            index.addDocument(document.view());
+        }
+    } else {
+        inFile = MappedFile{argv[i]};
+        if (!inFile) {
+            std::cerr << "\nError opening input file!" << std::endl;
+            return 1;
+        }
+        index.addLines(inFile.view());
+        lines = LineIndex{inFile.view()};
+    }
+    index.finish();
+
+    if (i + 1 < argc) {
+        for (i++; i < argc; i++)
+            printResults(argv[i], index, k, scoring, lines, files);
+    } else {
+        std::string query;
+        while (getline(std::cin, query))
+            printResults(query, index, k, scoring, lines, files);
+    }
+    return 0;
+}
+
+void printResults(const std::string& query, const RankedIndex& index, std::size_t k, Scoring scoring,
+                  const LineIndex& lines, const std::vector<std::string>& files) {
+    std::cout << "\n" << query << "\n";
+    std::cout << "======================================================" << std::endl;
+
+    for (const auto& result : index.search(query, k, scoring)) {
+        std::cout << std::setw(10) << std::right << std::fixed << std::setprecision(4) << result.score << "  ";
+        if (files.empty())
+            std::cout << "line " << result.document + 1 << ": " << lines.getLine(static_cast<int>(result.document) + 1);
+        else
+            std::cout << files[result.document];
+        std::cout << "\n";
+    }
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "Tokenizer.h"
+#include "CorpusGenerator.h"
+#include "LineIndex.h"
+#include "RankedIndex.h"
+
+// Query latency of RankedIndex::search() against scoring every matching
+// document, over a synthetic corpus where every line (~78 bytes) is a document.
+// Each query is 2 - 4 words picked from one random document (of those with at
+// least two words), so common words turn up about as often as they do in real
+// queries. Every MaxScore result is checked against the exhaustive one.
+//
+// Usage: RankedSearchBenchmark [documents, default 1000000] [queries, default 1000] [k, default 10]
+
+template <typename Search>
+void benchmark(const std::string& name, const std::vector<std::string>& queries, Search search);
+
+int main(int argc, char* argv[]) {
+    std::size_t documents {argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000};
+    std::size_t queryCount {argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000};
+    std::size_t k {argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10};
+    if (documents == 0 || queryCount == 0) {
+        std::cerr << "\nError: documents and queries must both be at least 1!" << std::endl;
+        return 1;
+    }
+
+    std::string corpus {generateCorpus(42, 100000, documents * 78, 1.0)};
+    LineIndex lines {corpus};
+
+    auto start = std::chrono::steady_clock::now();
+    RankedIndex index;
+    index.addLines(corpus);
+    index.finish();
+    double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    std::cout << index.size() << " documents, " << index.wordCount() << " words, built in "
+              << std::fixed << std::setprecision(2) << seconds << " s, "
+              << index.memoryUsage() / (1024 * 1024) << " MB\n\n";
+
+    // Queries are drawn from the documents that can make one, so a corpus of
+    // very short lines cannot keep the loop drawing forever
+    std::vector<int> pool;
+    for (std::size_t line {1}; line <= lines.size(); line++) {
+        std::size_t count {0};
+        forEachWord(lines.getLine(static_cast<int>(line)), [&count](std::string_view, int) { count++; });
+        if (count >= 2)
+            pool.push_back(static_cast<int>(line));
+    }
+    if (pool.empty()) {
+        std::cerr << "\nError: no document has two words to make a query from!" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 rng {7};
+    std::vector<std::string> queries;
+    while (queries.size() < queryCount) {
+        std::vector<std::string_view> words;
+        int line {pool[std::uniform_int_distribution<std::size_t>{0, pool.size() - 1}(rng)]};
+        forEachWord(lines.getLine(line), [&words](std::string_view word, int) { words.push_back(word); });
+        std::shuffle(words.begin(), words.end(), rng);
+        std::size_t n {std::min(words.size(), std::uniform_int_distribution<std::size_t>{2, 4}(rng))};
+        std::string query;
+        for (std::size_t i {0}; i < n; i++)
+            query += std::string{words[i]} + " ";
+        queries.push_back(query);
+    }
+
+    std::cout << std::setw(14) << std::left << "Search"
+              << std::setw(14) << std::right << "Scored/query"
+              << std::setw(10) << std::right << "p50 ms"
+              << std::setw(10) << std::right << "p99 ms"
+              << std::setw(10) << std::right << "max ms" << std::endl;
+    std::cout << std::string(58, '=') << std::endl;
+
+    for (auto scoring : {Scoring::bm25, Scoring::tfIdf}) {
+        std::string label {scoring == Scoring::bm25 ? "BM25" : "TF-IDF"};
+        std::vector<std::vector<ScoredDocument>> expected;
+        benchmark(label + " full", queries, [&](const std::string& query, std::size_t& scored) {
+            expected.push_back(index.searchExhaustive(query, k, scoring, &scored));
+        });
+
+        std::size_t mismatches {0};
+        std::size_t next {0};
+        benchmark(label + " MaxScore", queries, [&](const std::string& query, std::size_t& scored) {
+            std::vector<ScoredDocument> results {index.search(query, k, scoring, &scored)};
+            const auto& reference = expected[next++];
+            bool same {results.size() == reference.size()};
+            for (std::size_t i {0}; same && i < results.size(); i++)
+                same = results[i].document == reference[i].document;
+            mismatches += !same;
+        });
+        if (mismatches > 0)
+            std::cout << mismatches << " MaxScore results differ from the exhaustive ones!\n";
+    }
+    return 0;
+}
+
+template <typename Search>
+void benchmark(const std::string& name, const std::vector<std::string>& queries, Search search) {
+    if (queries.empty())
+        return;
+    std::vector<double> latencies;
+    std::size_t scored {0};
+    for (const auto& query : queries) {
+        std::size_t count {0};
+        auto start = std::chrono::steady_clock::now();
+        search(query, count);
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        scored += count;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1,
+                                  static_cast<std::size_t>(p * static_cast<double>(latencies.size())))];
+    };
+    std::cout << std::setw(14) << std::left << name
+              << std::setw(14) << std::right << scored / queries.size()
+              << std::setw(10) << std::right << std::fixed << std::setprecision(3) << percentile(0.50)
+              << std::setw(10) << std::right << percentile(0.99)
+              << std::setw(10) << std::right << latencies.back() << "\n";
+}
@@ -0,0 +1,138 @@
+#ifndef CPPNOTES_REPORTWRITER_H
+#define CPPNOTES_REPORTWRITER_H
+
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+#include <unistd.h>
+
+// Writes the displayCounts()/displayLines() reports byte for byte, but without
+// iostreams: numbers are formatted with std::to_chars, padding is copied from a
+// block of spaces instead of going through std::setw, and everything is
+// gathered in one reusable buffer that goes out to the file descriptor in a
+// few large write() calls.
+class ReportWriter {
+private:
+    static constexpr std::string_view spaces {"                                                                "};
+    int fd;
+    std::vector<char> buffer;
+    std::size_t used {0};
+    bool failed {false};
+
+    void reserve(std::size_t bytes) {
+        if (used + bytes > buffer.size()) {
+            flush();
+            if (bytes > buffer.size())
+                buffer.resize(bytes);
+        }
+    }
+
+    void append(std::string_view text) {
+        reserve(text.size());
+        std::memcpy(buffer.data() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void pad(std::size_t count) {
+        while (count > 0) {
+            std::size_t chunk {count < spaces.size() ? count : spaces.size()};
+            append(spaces.substr(0, chunk));
+            count -= chunk;
+        }
+    }
+
+    // Same as os << std::setw(width) << std::left << text
+    void appendLeft(std::string_view text, std::size_t width) {
+        append(text);
+        if (text.size() < width)
+            pad(width - text.size());
+    }
+
+    // Same as os << std::setw(width) << std::right << text
+    void appendRight(std::string_view text, std::size_t width) {
+        if (text.size() < width)
+            pad(width - text.size());
+        append(text);
+    }
+
+    void appendRight(long long value, std::size_t width) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        std::size_t length {static_cast<std::size_t>(result.ptr - digits)};
+        if (length < width)
+            pad(width - length);
+        append({digits, length});
+    }
+
+    void appendNumber(long long value) {
+        reserve(24);
+        auto result = std::to_chars(buffer.data() + used, buffer.data() + used + 24, value);
+        used = static_cast<std::size_t>(result.ptr - buffer.data());
+    }
+
+public:
+    explicit ReportWriter(int fd = STDOUT_FILENO, std::size_t capacity = 1 << 20)
+        : fd{fd}, buffer(capacity > 64 ? capacity : 64) { }
+
+    ReportWriter(const ReportWriter& other) = delete;
+    ReportWriter& operator=(const ReportWriter& rhs) = delete;
+
+    ~ReportWriter() { flush(); }
+
+    // Returns false if any write so far has failed
+    bool flush() {
+        std::size_t done {0};
+        while (done < used && !failed) {
+            ssize_t written {write(fd, buffer.data() + done, used - done)};
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                failed = true;
+            else
+                done += static_cast<std::size_t>(written);
+        }
+        used = 0;
+        return !failed;
+    }
+
+    template <typename Pairs>
+    void writeCounts(const Pairs& words) {
+        writeCountsHeader();
+        for (const auto& pair : words)
+            writeCount(pair.first, pair.second);
+    }
+
+    // writeCounts() a row at a time, for counts that arrive as a stream
+    void writeCountsHeader() {
+        appendLeft("\nWord", 12);
+        appendRight("Count", 7);
+        append("\n===========================\n");
+    }
+
+    void writeCount(std::string_view word, long long count) {
+        appendLeft(word, 12);
+        appendRight(count, 7);
+        append("\n");
+    }
+
+    template <typename Map>
+    void writeLines(const Map& words) {
+        appendLeft("\nWord", 12);
+        append("Line Occurrences\n======================================================\n");
+
+        for (const auto& pair : words) {
+            appendLeft(pair.first, 12);
+            append("[ ");
+            for (const auto& line : pair.second) {
+                appendNumber(line);
+                append(" ");
+            }
+            append("]\n");
+        }
+    }
+};
+
+#endif //CPPNOTES_REPORTWRITER_H
@@ -0,0 +1,406 @@
+#ifndef CPPNOTES_SEGMENTSTORE_H
+#define CPPNOTES_SEGMENTSTORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
+#include <queue>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "PostingList.h"
+#include "IndexFile.h"
+#include "QueryEngine.h"
+
+// One immutable index file of a SegmentStore. Its lines are numbered from 1
+// within the segment; lineBase is how many lines of the whole text come
+// before them.
+struct Segment {
+    std::string name;
+    int lineBase;
+    int lineCount;
+    int level;                  // 0 when added, +1 per merge
+    std::shared_ptr<const IndexView> index;
+};
+
+// A log structured (LSM style) index over text that keeps growing, one piece
+// at a time (a day's worth of logs, say).
+//
+// Every piece is indexed on its own and written once as an immutable sorted
+// segment: an ordinary index file (IndexFile.h). A MANIFEST file lists the live
+// segments in text order, with the line offset of each, and is replaced
+// atomically (write + rename) whenever that list changes. Lookups read every
+// live segment and shift its lines by the segment's offset, and since the
+// segments are in text order the results simply concatenate.
+//
+// So the number of segments stays small, whenever fanIn neighbouring segments
+// share a level they are merged into one segment a level up, on a background
+// thread: a k-way merge of their sorted vocabularies, with each word's posting
+// lists concatenated. Only the first gap of each list has to be re-encoded
+// for the line offset, the rest of the bytes are copied, and the text is
+// never tokenized again. Readers work on a snapshot of the segment list, so
+// they never wait for a merge.
+//
+// Segment files the manifest does not list, left behind by a crash between a
+// manifest rewrite and the unlink of what it retired, are deleted on open. A
+// store must only be opened by one process at a time.
+class SegmentStore {
+private:
+    using Segments = std::vector<Segment>;
+
+    std::string dir;
+    std::size_t fanIn;
+    mutable std::mutex lock;
+    std::condition_variable changed;
+    std::shared_ptr<const Segments> live {std::make_shared<const Segments>()};
+    std::uint64_t nextId {1};
+    bool valid {false};
+
+    std::thread merger;
+    bool stopping {false};
+    bool mergeWanted {false};
+    bool merging {false};
+
+    std::string pathOf(const std::string& name) const { return dir + "/" + name; }
+
+    // Called with lock held
+    bool writeManifest(const Segments& segments) const {
+        std::string temporary {pathOf("MANIFEST.tmp")};
+        {
+            std::ofstream outFile {temporary, std::ios::trunc};
+            outFile << "C3SEGMENTS1\n" << nextId << "\n";
+            for (const auto& segment : segments)
+                outFile << segment.name << " " << segment.lineBase << " " << segment.lineCount << " "
+                        << segment.level << "\n";
+            if (!outFile)
+                return false;
+        }
+        return std::rename(temporary.c_str(), pathOf("MANIFEST").c_str()) == 0;
+    }
+
+    bool readManifest() {
+        std::ifstream inFile {pathOf("MANIFEST")};
+        if (!inFile)
+            return !std::filesystem::exists(pathOf("MANIFEST"));
+
+        std::string magic;
+        auto segments = std::make_shared<Segments>();
+        if (!(inFile >> magic >> nextId) || magic != "C3SEGMENTS1")
+            return false;
+        Segment segment;
+        while (inFile >> segment.name >> segment.lineBase >> segment.lineCount >> segment.level) {
+            segment.index = std::make_shared<const IndexView>(pathOf(segment.name));
+            if (!*segment.index)
+                return false;
+            segments->push_back(segment);
+        }
+        live = segments;
+        return true;
+    }
+
+    // Writes words as a new segment file, returns its name ("" on failure)
+    std::string writeSegment(const IndexWriter& writer) {
+        std::string name;
+        {
+            std::lock_guard<std::mutex> guard {lock};
+            name = "segment-" + std::to_string(nextId++) + ".c3i";
+        }
+        std::string temporary {pathOf(name + ".tmp")};
+        if (!writer.write(temporary) || std::rename(temporary.c_str(), pathOf(name).c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return "";
+        }
+        return name;
+    }
+
+    // Appends lines to out shifted by offset, carrying on the gap encoding
+    // from last (the final line already in out). One streaming pass: the
+    // first gap is re-encoded for the offset and every later varint is copied
+    // as it is read, only summed up to keep track of the last line.
+    static void appendShifted(std::vector<std::uint8_t>& out, int& last, PostingView lines, int offset) {
+        const std::uint8_t* p {lines.data()};
+        const std::uint8_t* end {p + lines.byteSize()};
+        if (p == end)
+            return;
+        std::uint64_t gap;
+        p = getVarint(p, gap);
+        int line {static_cast<int>(gap) + offset};
+        putVarint(out, static_cast<std::uint64_t>(line - last));
+        while (p < end) {
+            const std::uint8_t* next {getVarint(p, gap)};
+            out.insert(out.end(), p, next);
+            line += static_cast<int>(gap);
+            p = next;
+        }
+        last = line;
+    }
+
+    // Merges segments[first, last) into one segment, or returns false
+    bool mergeSegments(const Segments& segments, std::size_t first, std::size_t last, Segment& merged) {
+        // (segment, word) cursors, smallest word first and then earliest segment
+        struct Cursor {
+            std::size_t segment;
+            std::size_t word;
+        };
+        auto later = [&segments](const Cursor& lhs, const Cursor& rhs) {
+            std::string_view left {segments[lhs.segment].index->word(lhs.word)};
+            std::string_view right {segments[rhs.segment].index->word(rhs.word)};
+            return left != right ? left > right : lhs.segment > rhs.segment;
+        };
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> queue {later};
+        for (std::size_t i {first}; i < last; i++)
+            if (segments[i].index->size() > 0)
+                queue.push({i, 0});
+
+        IndexWriter writer;
+        std::vector<std::uint8_t> lines;
+        while (!queue.empty()) {
+            std::string_view word {segments[queue.top().segment].index->word(queue.top().word)};
+            lines.clear();
+            int lastLine {0};
+            std::uint64_t lineCount {0};
+            while (!queue.empty() && segments[queue.top().segment].index->word(queue.top().word) == word) {
+                Cursor cursor {queue.top()};
+                queue.pop();
+                const IndexView& index {*segments[cursor.segment].index};
+                appendShifted(lines, lastLine, index.lines(cursor.word),
+                              segments[cursor.segment].lineBase - segments[first].lineBase);
+                lineCount += index.lineCount(cursor.word);
+                if (cursor.word + 1 < index.size())
+                    queue.push({cursor.segment, cursor.word + 1});
+            }
+            writer.add(word, PostingView{lines.data(), lines.data() + lines.size()}, lineCount);
+        }
+
+        merged.name = writeSegment(writer);
+        if (merged.name.empty())
+            return false;
+        merged.lineBase = segments[first].lineBase;
+        merged.lineCount = segments[last - 1].lineBase + segments[last - 1].lineCount - merged.lineBase;
+        merged.level = segments[first].level + 1;
+        merged.index = std::make_shared<const IndexView>(pathOf(merged.name));
+        return static_cast<bool>(*merged.index);
+    }
+
+    enum class Swap { done, stale, failed };
+
+    // Swaps segments[first, last) of an earlier snapshot for merged. If the
+    // live list no longer holds exactly those segments side by side (a
+    // compact() or another merge got there first) nothing changes, merged is
+    // deleted and the result is stale.
+    Swap replace(const Segments& segments, std::size_t first, std::size_t last, const Segment& merged) {
+        std::vector<std::string> retired;
+        {
+            std::lock_guard<std::mutex> guard {lock};
+            auto updated = std::make_shared<Segments>(*live);
+            auto iter = std::find_if(updated->begin(), updated->end(), [&](const Segment& segment) {
+                return segment.name == segments[first].name;
+            });
+            bool unchanged {static_cast<std::size_t>(updated->end() - iter) >= last - first};
+            for (std::size_t i {first}; unchanged && i < last; i++)
+                unchanged = iter[static_cast<std::ptrdiff_t>(i - first)].name == segments[i].name;
+            if (!unchanged) {
+                std::remove(pathOf(merged.name).c_str());
+                return Swap::stale;
+            }
+
+            for (std::size_t i {first}; i < last; i++)
+                retired.push_back(segments[i].name);
+            *iter = merged;
+            updated->erase(iter + 1, iter + static_cast<std::ptrdiff_t>(last - first));
+            if (!writeManifest(*updated))
+                return Swap::failed;
+            live = updated;
+        }
+        // Readers still holding an old snapshot keep their mapping after the unlink
+        for (const auto& old : retired)
+            std::remove(pathOf(old).c_str());
+        return Swap::done;
+    }
+
+    // Merges segments[first, last) of a snapshot and swaps the result in
+    Swap merge(const Segments& segments, std::size_t first, std::size_t last) {
+        Segment merged;
+        if (!mergeSegments(segments, first, last, merged)) {
+            if (!merged.name.empty())
+                std::remove(pathOf(merged.name).c_str());
+            return Swap::failed;
+        }
+        return replace(segments, first, last, merged);
+    }
+
+    // Deletes the segment files the manifest does not list: segments that
+    // were merged away, or half written, when the last process stopped
+    void removeOrphans() {
+        std::vector<std::string> names;
+        for (const auto& segment : *live)
+            names.push_back(segment.name);
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator {dir, error}) {
+            std::string name {entry.path().filename().string()};
+            bool ours {name.rfind("segment-", 0) == 0 || name == "MANIFEST.tmp"};
+            if (ours && std::find(names.begin(), names.end(), name) == names.end())
+                std::filesystem::remove(entry.path(), error);
+        }
+    }
+
+    void mergeLoop() {
+        std::unique_lock<std::mutex> guard {lock};
+        while (true) {
+            changed.wait(guard, [this]() { return stopping || mergeWanted; });
+            if (stopping)
+                return;
+            mergeWanted = false;
+            merging = true;
+            guard.unlock();
+            while (mergeOnce()) { }
+            guard.lock();
+            merging = false;
+            changed.notify_all();
+        }
+    }
+
+public:
+    // Opens (or creates) the store in dir. Converts to false if an existing
+    // manifest or one of its segments cannot be read.
+    explicit SegmentStore(std::string dir, std::size_t fanIn = 4) : dir{std::move(dir)}, fanIn{std::max<std::size_t>(fanIn, 2)} {
+        std::error_code error;
+        std::filesystem::create_directories(this->dir, error);
+        valid = !error && readManifest();
+        if (valid)
+            removeOrphans();
+    }
+
+    SegmentStore(const SegmentStore& other) = delete;
+    SegmentStore& operator=(const SegmentStore& rhs) = delete;
+
+    ~SegmentStore() {
+        {
+            std::lock_guard<std::mutex> guard {lock};
+            stopping = true;
+        }
+        changed.notify_all();
+        if (merger.joinable())
+            merger.join();
+    }
+
+    explicit operator bool() const { return valid; }
+
+    // Indexes text as a new segment whose lines follow all the existing ones
+    bool addText(std::string_view text) {
+        WordPostings words;
+        forEachWord(text, [&words](std::string_view word, int line) {
+            addWord(words, word, line);
+        });
+        int lineCount {static_cast<int>(std::count(text.begin(), text.end(), '\n'))};
+        if (!text.empty() && text.back() != '\n')
+            lineCount++;
+        return addSegment(words, lineCount);
+    }
+
+    // Adds an already built index of lineCount lines as a new segment
+    bool addSegment(const WordPostings& words, int lineCount) {
+        IndexWriter writer;
+        for (const auto& pair : words)
+            writer.add(pair.first, pair.second);
+        Segment segment {writeSegment(writer), 0, lineCount, 0, nullptr};
+        if (segment.name.empty())
+            return false;
+        segment.index = std::make_shared<const IndexView>(pathOf(segment.name));
+        if (!*segment.index)
+            return false;
+
+        {
+            std::lock_guard<std::mutex> guard {lock};
+            auto segments = std::make_shared<Segments>(*live);
+            if (!segments->empty())
+                segment.lineBase = segments->back().lineBase + segments->back().lineCount;
+            segments->push_back(segment);
+            if (!writeManifest(*segments))
+                return false;
+            live = segments;
+            mergeWanted = true;
+        }
+        changed.notify_all();
+        return true;
+    }
+
+    // Merges the newest run of fanIn segments that share a level, if there is
+    // one. Returns whether anything was merged (or the segments changed under
+    // the merge, so it is worth looking again).
+    bool mergeOnce() {
+        std::shared_ptr<const Segments> segments {snapshot()};
+        for (std::size_t last {segments->size()}; last >= fanIn; last--) {
+            std::size_t first {last - fanIn};
+            bool sameLevel {true};
+            for (std::size_t i {first + 1}; i < last; i++)
+                sameLevel = sameLevel && (*segments)[i].level == (*segments)[first].level;
+            if (!sameLevel)
+                continue;
+
+            return merge(*segments, first, last) != Swap::failed;
+        }
+        return false;
+    }
+
+    // Merges every live segment into one, starting over if a background
+    // merge changes the segments first
+    bool compact() {
+        while (true) {
+            std::shared_ptr<const Segments> segments {snapshot()};
+            if (segments->size() < 2)
+                return true;
+            Swap result {merge(*segments, 0, segments->size())};
+            if (result != Swap::stale)
+                return result == Swap::done;
+        }
+    }
+
+    // Runs mergeOnce() on a background thread after every addSegment()
+    void startBackgroundMerges() {
+        std::lock_guard<std::mutex> guard {lock};
+        if (!merger.joinable())
+            merger = std::thread {&SegmentStore::mergeLoop, this};
+        mergeWanted = true;
+        changed.notify_all();
+    }
+
+    // Blocks until the background thread has nothing left to merge
+    void waitForMerges() {
+        std::unique_lock<std::mutex> guard {lock};
+        if (merger.joinable())
+            changed.wait(guard, [this]() { return !mergeWanted && !merging; });
+    }
+
+    // The live segments right now. A snapshot stays readable however the
+    // store changes afterwards.
+    std::shared_ptr<const Segments> snapshot() const {
+        std::lock_guard<std::mutex> guard {lock};
+        return live;
+    }
+
+    // Lines of word across every live segment, ascending
+    LineList lookup(std::string_view word) const {
+        LineList lines;
+        for (const auto& segment : *snapshot())
+            for (int line : segment.index->lookup(word))
+                lines.push_back(line + segment.lineBase);
+        return lines;
+    }
+};
+
+inline LineList lookupLines(const SegmentStore& store, std::string_view word) {
+    return store.lookup(word);
+}
+
+#endif //CPPNOTES_SEGMENTSTORE_H
@@ -0,0 +1,318 @@
+#ifndef CPPNOTES_SPILLINGCOUNTER_H
+#define CPPNOTES_SPILLINGCOUNTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <queue>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <unistd.h>
+
+// Scratch file that the runs are appended to, back to back. It is unlinked as
+// soon as it is created, so it disappears with the descriptor even if the
+// program is killed.
+class SpillFile {
+private:
+    int fd {-1};
+    std::uint64_t length {0};
+    bool failed {false};
+
+public:
+    explicit SpillFile(const std::string& dir) {
+        std::string path {dir + "/challenge3_spill_XXXXXX"};
+        fd = mkstemp(path.data());
+        if (fd >= 0)
+            unlink(path.c_str());
+        failed = fd < 0;
+    }
+
+    SpillFile(const SpillFile& other) = delete;
+    SpillFile& operator=(const SpillFile& rhs) = delete;
+
+    ~SpillFile() {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool append(const std::uint8_t* data, std::size_t size) {
+        while (size > 0 && !failed) {
+            ssize_t written {pwrite(fd, data, size, static_cast<off_t>(length))};
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                failed = true;
+            else {
+                data += written;
+                size -= static_cast<std::size_t>(written);
+                length += static_cast<std::uint64_t>(written);
+            }
+        }
+        return !failed;
+    }
+
+    // Bytes read, 0 at the end of the file or on an error
+    std::size_t read(std::uint64_t offset, std::uint8_t* data, std::size_t size) {
+        while (!failed) {
+            ssize_t got {pread(fd, data, size, static_cast<off_t>(offset))};
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0)
+                failed = true;
+            return got > 0 ? static_cast<std::size_t>(got) : 0;
+        }
+        return 0;
+    }
+
+    std::uint64_t size() const { return length; }
+    bool good() const { return !failed; }
+};
+
+// A run is one sorted stretch of a SpillFile: (varint length, bytes,
+// varint count) records in word order
+struct Run {
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+// Appends one run to a SpillFile through a buffer
+class RunWriter {
+private:
+    SpillFile& file;
+    std::vector<std::uint8_t> buffer;
+    std::uint64_t begin;
+
+    void writeVarint(std::uint64_t value) {
+        if (buffer.size() + 10 > buffer.capacity())
+            flush();
+        while (value >= 0x80) {
+            buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    void flush() {
+        file.append(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+public:
+    RunWriter(SpillFile& file, std::size_t bufferSize) : file{file}, begin{file.size()} {
+        buffer.reserve(std::max<std::size_t>(bufferSize, 64));
+    }
+
+    void append(std::string_view word, std::uint64_t count) {
+        writeVarint(word.size());
+        while (!word.empty()) {
+            if (buffer.size() == buffer.capacity())
+                flush();
+            std::size_t take {std::min(word.size(), buffer.capacity() - buffer.size())};
+            buffer.insert(buffer.end(), word.begin(), word.begin() + static_cast<std::ptrdiff_t>(take));
+            word.remove_prefix(take);
+        }
+        writeVarint(count);
+    }
+
+    Run finish() {
+        flush();
+        return {begin, file.size()};
+    }
+};
+
+// Reads one run back through a buffer
+class RunReader {
+private:
+    SpillFile* file;
+    std::uint64_t offset;
+    std::uint64_t end;
+    std::vector<std::uint8_t> buffer;
+    std::size_t position {0};
+    std::size_t filled {0};
+
+    bool nextByte(std::uint8_t& byte) {
+        if (position == filled) {
+            std::size_t want {static_cast<std::size_t>(std::min<std::uint64_t>(buffer.size(), end - offset))};
+            filled = want > 0 ? file->read(offset, buffer.data(), want) : 0;
+            offset += filled;
+            position = 0;
+            if (filled == 0)
+                return false;
+        }
+        byte = buffer[position++];
+        return true;
+    }
+
+    bool nextVarint(std::uint64_t& value) {
+        value = 0;
+        std::uint8_t byte;
+        for (int shift {0}; nextByte(byte); shift += 7) {
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+public:
+    RunReader(SpillFile& file, Run run, std::size_t bufferSize)
+        : file{&file}, offset{run.begin}, end{run.end}, buffer(std::max<std::size_t>(bufferSize, 64)) { }
+
+    // Reads the next record, false at the end of the run
+    bool next(std::string& word, std::uint64_t& count) {
+        std::uint64_t length;
+        if (!nextVarint(length))
+            return false;
+        word.clear();
+        std::uint8_t byte;
+        while (word.size() < length) {
+            if (position < filled) {
+                std::size_t take {std::min<std::size_t>(length - word.size(), filled - position)};
+                word.append(reinterpret_cast<const char*>(buffer.data() + position), take);
+                position += take;
+            } else if (nextByte(byte))
+                word += static_cast<char>(byte);
+            else
+                return false;
+        }
+        return nextVarint(count);
+    }
+};
+
+// Exact part 1 counts within a fixed memory budget, however many distinct
+// words there are.
+//
+// Words are counted in an ordinary sorted map until its estimated size reaches
+// the budget. The map is then written out, already in order, as a run at the
+// end of a scratch file and cleared. At the end the runs are merged k ways
+// (adding up the counts of a word that appears in several runs) and the words
+// come out in order one at a time, so the final counts never have to fit in
+// memory either. If there are more runs than the budget has room for read
+// buffers, groups of them are first merged into longer runs at the end of the
+// same file.
+class SpillingCounter {
+private:
+    // std::map node, std::string and malloc overhead per entry, roughly
+    static constexpr std::size_t entryOverhead {96};
+
+    std::map<std::string, std::uint64_t, std::less<>> counts;
+    std::size_t budget;
+    std::size_t used {0};
+    std::size_t bufferSize;
+    std::string tempDir;
+    std::unique_ptr<SpillFile> file;
+    std::vector<Run> runs;
+
+    void spill() {
+        if (!file)
+            file = std::make_unique<SpillFile>(tempDir);
+        RunWriter writer {*file, bufferSize};
+        for (const auto& pair : counts)
+            writer.append(pair.first, pair.second);
+        runs.push_back(writer.finish());
+        counts.clear();
+        used = 0;
+    }
+
+    // Merges runs[first, last) in word order, calling onWord(word, count) once
+    // per distinct word
+    template <typename OnWord>
+    void merge(std::size_t first, std::size_t last, OnWord&& onWord) {
+        struct Head {
+            RunReader reader;
+            std::string word;
+            std::uint64_t count;
+        };
+        std::vector<Head> heads;
+        heads.reserve(last - first);
+        for (std::size_t i {first}; i < last; i++)
+            heads.push_back({RunReader{*file, runs[i], bufferSize}, {}, 0});
+
+        auto later = [&heads](std::size_t lhs, std::size_t rhs) { return heads[lhs].word > heads[rhs].word; };
+        std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> queue {later};
+        for (std::size_t i {0}; i < heads.size(); i++)
+            if (heads[i].reader.next(heads[i].word, heads[i].count))
+                queue.push(i);
+
+        std::string word;
+        while (!queue.empty()) {
+            std::size_t i {queue.top()};
+            queue.pop();
+            word.swap(heads[i].word);
+            std::uint64_t total {heads[i].count};
+            if (heads[i].reader.next(heads[i].word, heads[i].count))
+                queue.push(i);
+
+            while (!queue.empty() && heads[queue.top()].word == word) {
+                std::size_t j {queue.top()};
+                queue.pop();
+                total += heads[j].count;
+                if (heads[j].reader.next(heads[j].word, heads[j].count))
+                    queue.push(j);
+            }
+            onWord(std::string_view{word}, total);
+        }
+    }
+
+public:
+    static std::string defaultTempDir() {
+        const char* dir {std::getenv("TMPDIR")};
+        return dir != nullptr && *dir != '\0' ? dir : "/tmp";
+    }
+
+    // Read and write buffers are a slice of the budget, up to 1 MB each
+    explicit SpillingCounter(std::size_t budgetBytes, std::string tempDir = defaultTempDir())
+        : budget{std::max<std::size_t>(budgetBytes, 64 << 10)},
+          bufferSize{std::min<std::size_t>(budget / 16, 1 << 20)}, tempDir{std::move(tempDir)} { }
+
+    void add(std::string_view word) {
+        auto iter = counts.lower_bound(word);
+        if (iter != counts.end() && iter->first == word)
+            iter->second++;
+        else {
+            counts.emplace_hint(iter, word, 1);
+            used += entryOverhead + (word.size() > 15 ? word.size() + 1 : 0);
+            if (used >= budget)
+                spill();
+        }
+    }
+
+    // Calls onWord(word, count) for every distinct word in ascending order.
+    // Returns false if the scratch file could not be written or read back.
+    template <typename OnWord>
+    bool finish(OnWord&& onWord) {
+        if (runs.empty()) {
+            for (const auto& pair : counts)
+                onWord(std::string_view{pair.first}, pair.second);
+            return true;
+        }
+        if (!counts.empty())
+            spill();
+
+        // Each run being merged holds a read buffer
+        std::size_t fanIn {std::max<std::size_t>(budget / bufferSize, 2)};
+        std::size_t first {0};
+        for (; runs.size() - first > fanIn && file->good(); first += fanIn) {
+            RunWriter writer {*file, bufferSize};
+            merge(first, first + fanIn, [&writer](std::string_view word, std::uint64_t count) {
+                writer.append(word, count);
+            });
+            runs.push_back(writer.finish());
+        }
+        if (file->good())
+            merge(first, runs.size(), onWord);
+        return file->good();
+    }
+
+    // How many sorted runs were written, merges included
+    std::size_t runCount() const { return runs.size(); }
+};
+
+#endif //CPPNOTES_SPILLINGCOUNTER_H
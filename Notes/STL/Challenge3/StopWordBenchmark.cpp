@@ -0,0 +1,106 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <unordered_set>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "Tokenizer.h"
+#include "CorpusGenerator.h"
+#include "StopWords.h"
+
+// Per token cost of the stopword check: a lower cased copy looked up in a
+// std::set and in a std::unordered_set, against the constexpr PerfectHashSet.
+// The tokens are a synthetic corpus with stopwords (in mixed case) mixed in at
+// about the rate of English prose, already split and cleaned, so only the
+// lookup itself is timed.
+//
+// Usage: StopWordBenchmark [synthetic size in MB, default 64]
+
+template <typename IsStopWord>
+void benchmark(const std::string& name, const std::vector<std::string_view>& tokens, IsStopWord isStopWord);
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes {argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64};
+    std::string corpus {generateCorpus(42, 100000, megabytes * 1024 * 1024, 1.0)};
+
+    // Put a stopword in front of ~45% of the words, in its listed, capitalised
+    // or upper case form
+    std::string text;
+    text.reserve(corpus.size() * 2);
+    std::mt19937_64 rng {7};
+    std::uniform_int_distribution<std::size_t> pick {0, stopWordList.size() - 1};
+    std::uniform_int_distribution<int> percent {0, 99};
+    forEachWord(corpus, [&](std::string_view word, int) {
+        if (percent(rng) < 45) {
+            std::string stopWord {stopWordList[pick(rng)]};
+            int roll {percent(rng)};
+            if (roll < 15)
+                stopWord[0] = static_cast<char>(stopWord[0] - 'a' + 'A');
+            else if (roll < 17)
+                for (auto& c : stopWord)
+                    if (c >= 'a' && c <= 'z')
+                        c = static_cast<char>(c - 'a' + 'A');
+            text += stopWord;
+            text += ' ';
+        }
+        text += word;
+        text += ' ';
+    });
+
+    std::vector<std::string> storage;
+    std::vector<std::string_view> tokens;
+    forEachWord(text, [&storage](std::string_view word, int) { storage.emplace_back(word); });
+    tokens.assign(storage.begin(), storage.end());
+
+    std::set<std::string, std::less<>> ordered;
+    std::unordered_set<std::string> hashed;
+    for (auto stopWord : stopWordList) {
+        ordered.emplace(stopWord);
+        hashed.emplace(stopWord);
+    }
+
+    std::cout << std::setw(24) << std::left << "Stopword set"
+              << std::setw(14) << std::right << "Tokens"
+              << std::setw(14) << std::right << "Stopwords"
+              << std::setw(12) << std::right << "ns/token" << std::endl;
+    std::cout << std::string(64, '=') << std::endl;
+
+    std::string lowered;
+    benchmark("std::set", tokens, [&](std::string_view word) {
+        lowered.assign(word);
+        for (auto& c : lowered)
+            c = foldCase(c);
+        return ordered.find(lowered) != ordered.end();
+    });
+
+    benchmark("std::unordered_set", tokens, [&](std::string_view word) {
+        lowered.assign(word);
+        for (auto& c : lowered)
+            c = foldCase(c);
+        return hashed.find(lowered) != hashed.end();
+    });
+
+    benchmark("constexpr perfect hash", tokens, [](std::string_view word) {
+        return isStopWord(word);
+    });
+    return 0;
+}
+
+template <typename IsStopWord>
+void benchmark(const std::string& name, const std::vector<std::string_view>& tokens, IsStopWord isStopWord) {
+    std::size_t hits {0};
+    auto start = std::chrono::steady_clock::now();
+    for (auto token : tokens)
+        hits += isStopWord(token);
+    double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+    std::cout << std::setw(24) << std::left << name
+              << std::setw(14) << std::right << tokens.size()
+              << std::setw(14) << std::right << hits
+              << std::setw(12) << std::right << std::fixed << std::setprecision(1)
+              << seconds * 1e9 / static_cast<double>(tokens.size()) << "\n";
+}
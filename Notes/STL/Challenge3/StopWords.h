@@ -0,0 +1,177 @@
+#ifndef CPPNOTES_STOPWORDS_H
+#define CPPNOTES_STOPWORDS_H
+
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "WordHash.h"
+
+constexpr char foldCase(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// FNV-1a over the lower cased bytes, so "The" and "the" hash the same
+constexpr std::uint64_t foldedHash(std::string_view word) {
+    std::uint64_t h {0xcbf29ce484222325ULL};
+    for (char c : word)
+        h = (h ^ static_cast<unsigned char>(foldCase(c))) * 0x100000001b3ULL;
+    return mixHash(h);
+}
+
+constexpr bool equalsFolded(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size())
+        return false;
+    for (std::size_t i {0}; i < lhs.size(); i++)
+        if (foldCase(lhs[i]) != foldCase(rhs[i]))
+            return false;
+    return true;
+}
+
+constexpr std::size_t nextPowerOfTwo(std::size_t n) {
+    std::size_t power {1};
+    while (power < n)
+        power *= 2;
+    return power;
+}
+
+// A fixed set of words, matched case-insensitively, laid out by a perfect
+// hash that is computed entirely at compile time.
+//
+// It is a hash-and-displace (CHD) scheme: one hash of the word picks a bucket
+// of two or three keys, and each bucket stores a small displacement that was
+// chosen so that mixing it into the hash sends every key of the bucket to its
+// own empty slot. Buckets are placed largest first, while the table is still
+// empty enough for them to fit. A lookup is then one hash of the word, a
+// couple of multiplies and a single key comparison: there are no collisions to
+// probe past and no second hash of the string.
+template <std::size_t N>
+class PerfectHashSet {
+private:
+    static constexpr std::size_t tableSize {nextPowerOfTwo(N + N / 2)};
+    static constexpr std::size_t bucketCount {nextPowerOfTwo(N / 4 > 0 ? N / 4 : 1)};
+    std::array<std::string_view, tableSize> keys {};
+    std::array<std::uint16_t, bucketCount> displacements {};
+    bool built {false};
+
+    static constexpr std::size_t bucketOf(std::uint64_t hash) {
+        return static_cast<std::size_t>(hash >> 32) & (bucketCount - 1);
+    }
+
+    static constexpr std::size_t slotOf(std::uint64_t hash, std::uint16_t displacement) {
+        return static_cast<std::size_t>(mixHash(hash + displacement * 0x9e3779b97f4a7c15ULL)) & (tableSize - 1);
+    }
+
+public:
+    // built stays false if some bucket could not be placed, which only happens
+    // when words has duplicates
+    constexpr explicit PerfectHashSet(const std::array<std::string_view, N>& words) {
+        // Group the keys by bucket (a counting sort)
+        std::array<std::uint64_t, N> hashes {};
+        std::array<std::size_t, bucketCount + 1> starts {};
+        for (std::size_t i {0}; i < N; i++) {
+            hashes[i] = foldedHash(words[i]);
+            starts[bucketOf(hashes[i]) + 1]++;
+        }
+        std::size_t largest {0};
+        for (std::size_t b {0}; b < bucketCount; b++) {
+            if (starts[b + 1] > largest)
+                largest = starts[b + 1];
+            starts[b + 1] += starts[b];
+        }
+        std::array<std::size_t, N> order {};
+        std::array<std::size_t, bucketCount> filled {};
+        for (std::size_t i {0}; i < N; i++) {
+            std::size_t b {bucketOf(hashes[i])};
+            order[starts[b] + filled[b]++] = i;
+        }
+
+        std::array<bool, tableSize> used {};
+        for (std::size_t size {largest}; size > 0; size--) {
+            for (std::size_t b {0}; b < bucketCount; b++) {
+                if (starts[b + 1] - starts[b] != size)
+                    continue;
+
+                bool placed {false};
+                for (std::uint32_t d {0}; d <= 0xffff && !placed; d++) {
+                    auto displacement = static_cast<std::uint16_t>(d);
+                    placed = true;
+                    for (std::size_t j {starts[b]}; j < starts[b + 1] && placed; j++) {
+                        std::size_t slot {slotOf(hashes[order[j]], displacement)};
+                        placed = !used[slot];
+                        for (std::size_t k {starts[b]}; k < j && placed; k++)
+                            placed = slotOf(hashes[order[k]], displacement) != slot;
+                    }
+                    if (placed) {
+                        for (std::size_t j {starts[b]}; j < starts[b + 1]; j++) {
+                            std::size_t slot {slotOf(hashes[order[j]], displacement)};
+                            used[slot] = true;
+                            keys[slot] = words[order[j]];
+                        }
+                        displacements[b] = displacement;
+                    }
+                }
+                if (!placed)
+                    return;
+            }
+        }
+        built = true;
+    }
+
+    constexpr bool contains(std::string_view word) const {
+        std::uint64_t hash {foldedHash(word)};
+        std::string_view key {keys[slotOf(hash, displacements[bucketOf(hash)])]};
+        // Empty slots hold an empty view, and no key is empty
+        return !key.empty() && equalsFolded(key, word);
+    }
+
+    constexpr bool valid() const { return built; }
+    static constexpr std::size_t size() { return N; }
+    static constexpr std::size_t memoryUsage() {
+        return tableSize * sizeof(std::string_view) + bucketCount * sizeof(std::uint16_t);
+    }
+};
+
+// Common English words that carry no meaning on their own and are left out
+// of the index when --stopwords is on (all lower case, matched in any case)
+constexpr std::array<std::string_view, 314> stopWordList {
+    "a", "about", "above", "across", "after", "afterwards", "again", "against", "all", "almost",
+    "alone", "along", "already", "also", "although", "always", "am", "among", "amongst", "an",
+    "and", "another", "any", "anyhow", "anyone", "anything", "anyway", "anywhere", "are", "aren't",
+    "around", "as", "at", "back", "be", "became", "because", "become", "becomes", "becoming",
+    "been", "before", "beforehand", "behind", "being", "below", "beside", "besides", "between",
+    "beyond", "both", "but", "by", "can", "cannot", "can't", "could", "couldn't", "did", "didn't",
+    "do", "does", "doesn't", "doing", "done", "don't", "down", "during", "each", "either", "else",
+    "elsewhere", "enough", "etc", "even", "ever", "every", "everyone", "everything", "everywhere",
+    "except", "few", "first", "for", "former", "formerly", "from", "further", "had", "hadn't",
+    "has", "hasn't", "have", "haven't", "having", "he", "he'd", "he'll", "hence", "her", "here",
+    "hereafter", "hereby", "herein", "here's", "hers", "herself", "he's", "him", "himself", "his",
+    "how", "however", "how's", "i", "i'd", "ie", "if", "i'll", "i'm", "in", "indeed", "into", "is",
+    "isn't", "it", "its", "it's", "itself", "i've", "just", "last", "latter", "latterly", "least",
+    "less", "let's", "like", "made", "many", "may", "me", "meanwhile", "might", "mine", "more",
+    "moreover", "most", "mostly", "much", "must", "mustn't", "my", "myself", "namely", "neither",
+    "never", "nevertheless", "next", "no", "nobody", "none", "noone", "nor", "not", "nothing",
+    "now", "nowhere", "of", "off", "often", "on", "once", "one", "only", "onto", "or", "other",
+    "others", "otherwise", "ought", "our", "ours", "ourselves", "out", "over", "own", "per",
+    "perhaps", "please", "put", "rather", "re", "same", "see", "seem", "seemed", "seeming",
+    "seems", "several", "shan't", "she", "she'd", "she'll", "she's", "should", "shouldn't",
+    "since", "so", "some", "somehow", "someone", "something", "sometime", "sometimes", "somewhere",
+    "still", "such", "than", "that", "that's", "the", "their", "theirs", "them", "themselves",
+    "then", "thence", "there", "thereafter", "thereby", "therefore", "therein", "there's",
+    "thereupon", "these", "they", "they'd", "they'll", "they're", "they've", "this", "those",
+    "though", "through", "throughout", "thru", "thus", "to", "together", "too", "toward",
+    "towards", "under", "until", "up", "upon", "us", "very", "via", "was", "wasn't", "we", "we'd",
+    "well", "we'll", "were", "we're", "weren't", "we've", "what", "whatever", "what's", "when",
+    "whence", "whenever", "when's", "where", "whereafter", "whereas", "whereby", "wherein",
+    "where's", "whereupon", "wherever", "whether", "which", "while", "whither", "who", "whoever",
+    "whole", "whom", "who's", "whose", "why", "why's", "will", "with", "within", "without",
+    "won't", "would", "wouldn't", "yet", "you", "you'd", "you'll", "your", "you're", "yours",
+    "yourself", "yourselves", "you've"
+};
+
+inline constexpr PerfectHashSet<stopWordList.size()> stopWords {stopWordList};
+static_assert(stopWords.valid(), "stopWordList has a duplicate word");
+
+inline bool isStopWord(std::string_view word) { return stopWords.contains(word); }
+
+#endif //CPPNOTES_STOPWORDS_H
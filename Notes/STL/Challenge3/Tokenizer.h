@@ -0,0 +1,140 @@
+#ifndef CPPNOTES_TOKENIZER_H
+#define CPPNOTES_TOKENIZER_H
+
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include "WordClassifier.h"
+
+// Same characters cleanStr() removes from a word
+inline bool isWordPunct(char c) {
+    return c == '.' || c == ',' || c == ';' || c == ':';
+}
+
+// Same characters operator>> skips between words in the "C" locale
+inline bool isWordSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Strips the punctuation from a raw word the way cleanStr() does, but without
+// allocating. Leading and trailing punctuation is trimmed off the view; only a
+// word with punctuation in the middle (e.g. "a,b") is copied into scratch.
+inline std::string_view cleanWord(std::string_view raw, std::string& scratch) {
+    std::size_t begin {0};
+    std::size_t end {raw.size()};
+    while (begin < end && isWordPunct(raw[begin]))
+        begin++;
+    while (end > begin && isWordPunct(raw[end - 1]))
+        end--;
+
+    std::string_view word {raw.substr(begin, end - begin)};
+    for (std::size_t i {0}; i < word.size(); i++) {
+        if (isWordPunct(word[i])) {
+            scratch.assign(word.data(), i);
+            for (std::size_t j {i + 1}; j < word.size(); j++)
+                if (!isWordPunct(word[j]))
+                    scratch += word[j];
+            return scratch;
+        }
+    }
+    return word;
+}
+
+// Calls onWord(word, lineNumber) for every word in text, giving the same words
+// and line numbers as getline() + operator>> + cleanStr() would.
+// The views are only valid for the duration of the call.
+//
+// The text is classified 64 bytes at a time by a (SIMD) ClassifyKernel, and
+// word boundaries, line numbers and "needs cleaning" all come out of the masks
+// with bit tricks rather than a branch per character. Only a word that really
+// contains punctuation goes through cleanWord().
+template <typename OnWord>
+void forEachWord(std::string_view text, OnWord&& onWord, int firstLine = 1,
+                 ClassifyKernel classify = bestClassifyKernel()) {
+    std::string scratch;
+    const char* data {text.data()};
+    const std::size_t size {text.size()};
+    int lineCount {firstLine};      // line the current block starts on
+
+    bool inWord {false};
+    bool wordPunct {false};
+    std::size_t wordStart {0};
+    int wordLine {0};
+
+    auto emit = [&](std::size_t end) {
+        std::string_view word {data + wordStart, end - wordStart};
+        onWord(wordPunct ? cleanWord(word, scratch) : word, wordLine);
+    };
+
+    char tail[64];
+    for (std::size_t base {0}; base < size; base += 64) {
+        const char* block {data + base};
+        if (size - base < 64) {
+            // Pad the last partial block with spaces so no kernel reads past the end
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, size - base);
+            block = tail;
+        }
+
+        BlockMasks masks;
+        classify(block, masks);
+
+        std::uint64_t wordBytes {~masks.space};
+        std::uint64_t previous {(wordBytes << 1) | (inWord ? 1 : 0)};
+        std::uint64_t starts {wordBytes & ~previous};
+        std::uint64_t ends {~wordBytes & previous};  // the space just after a word
+        std::uint64_t fromStart {inWord ? ~0ULL : 0};
+
+        for (std::uint64_t edges {starts | ends}; edges != 0; edges &= edges - 1) {
+            int i {__builtin_ctzll(edges)};
+            std::uint64_t below {(1ULL << i) - 1};
+
+            if (starts & (1ULL << i)) {
+                inWord = true;
+                wordStart = base + i;
+                wordLine = lineCount + __builtin_popcountll(masks.newline & below);
+                wordPunct = false;
+                fromStart = ~below;
+            } else {
+                wordPunct |= (masks.punct & fromStart & below) != 0;
+                emit(base + i);
+                inWord = false;
+            }
+        }
+
+        if (inWord)
+            wordPunct |= (masks.punct & fromStart) != 0;
+        lineCount += __builtin_popcountll(masks.newline);
+    }
+
+    if (inWord)
+        emit(size);
+}
+
+// Byte at a time version of forEachWord(), kept as the reference the block
+// version is checked and benchmarked against.
+template <typename OnWord>
+void forEachWordScalar(std::string_view text, OnWord&& onWord, int firstLine = 1) {
+    std::string scratch;
+    const char* p {text.data()};
+    const char* end {p + text.size()};
+    int lineCount {firstLine};
+
+    while (p < end) {
+        if (isWordSpace(*p)) {
+            if (*p == '\n')
+                lineCount++;
+            p++;
+            continue;
+        }
+
+        const char* start {p};
+        while (p < end && !isWordSpace(*p))
+            p++;
+        onWord(cleanWord({start, static_cast<std::size_t>(p - start)}, scratch), lineCount);
+    }
+}
+
+#endif //CPPNOTES_TOKENIZER_H
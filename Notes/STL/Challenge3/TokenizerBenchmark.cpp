@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <cstdlib>
+#include "Tokenizer.h"
+#include "CorpusGenerator.h"
+
+// Tokenizer throughput in MB/s: the original getline + stringstream + cleanStr
+// loop against the byte at a time forEachWordScalar() and forEachWord() with
+// each ClassifyKernel.
+//
+// Usage: TokenizerBenchmark [synthetic size in MB, default 256]
+
+std::string cleanStr(const std::string& str);
+template <typename Tokenize>
+void benchmark(const std::string& name, std::string_view text, Tokenize tokenize);
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes {argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256};
+    std::string corpus {generateCorpus(42, 100000, megabytes * 1024 * 1024)};
+
+    std::cout << std::setw(24) << std::left << "Tokenizer"
+              << std::setw(14) << std::right << "Words"
+              << std::setw(12) << std::right << "Seconds"
+              << std::setw(12) << std::right << "MB/s" << std::endl;
+    std::cout << std::string(62, '=') << std::endl;
+
+    benchmark("getline + stringstream", corpus, [](std::string_view text, std::size_t& words) {
+        std::istringstream inFile {std::string{text}};
+        std::string line;
+        std::string word;
+        while (getline(inFile, line)) {
+            std::stringstream ss {line};
+            while (ss >> word) {
+                word = cleanStr(word);
+                words += word.size() > 0;
+            }
+        }
+    });
+
+    benchmark("byte at a time", corpus, [](std::string_view text, std::size_t& words) {
+        forEachWordScalar(text, [&words](std::string_view word, int) { words += word.size() > 0; });
+    });
+
+    benchmark("blocks, scalar kernel", corpus, [](std::string_view text, std::size_t& words) {
+        forEachWord(text, [&words](std::string_view word, int) { words += word.size() > 0; }, 1, classifyScalar);
+    });
+
+#ifdef CPPNOTES_X86
+    benchmark("blocks, SSE2 kernel", corpus, [](std::string_view text, std::size_t& words) {
+        forEachWord(text, [&words](std::string_view word, int) { words += word.size() > 0; }, 1, classifySse2);
+    });
+
+    if (__builtin_cpu_supports("avx2")) {
+        benchmark("blocks, AVX2 kernel", corpus, [](std::string_view text, std::size_t& words) {
+            forEachWord(text, [&words](std::string_view word, int) { words += word.size() > 0; }, 1, classifyAvx2);
+        });
+    }
+#endif
+    return 0;
+}
+
+template <typename Tokenize>
+void benchmark(const std::string& name, std::string_view text, Tokenize tokenize) {
+    std::size_t words {0};
+    auto start = std::chrono::steady_clock::now();
+    tokenize(text, words);
+    double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+
+    std::cout << std::setw(24) << std::left << name
+              << std::setw(14) << std::right << words
+              << std::setw(12) << std::right << std::fixed << std::setprecision(3) << seconds
+              << std::setw(12) << std::right << std::setprecision(1)
+              << static_cast<double>(text.size()) / (1024 * 1024) / seconds << "\n";
+}
+
+std::string cleanStr(const std::string& str) {
+    std::string result;
+    for (const auto& c : str) {
+        if (c == '.' || c == ',' || c == ';' || c == ':')
+            continue;
+        else result += c;
+    }
+
+    return result;
+}
@@ -0,0 +1,125 @@
+#ifndef CPPNOTES_TOPK_H
+#define CPPNOTES_TOPK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+
+// Space-Saving heavy hitters (Metwally, Agrawal & El Abbadi): approximate word
+// counts in memory fixed by the number of counters, however large the vocabulary.
+//
+// Each monitored word has a count and an error. When a new word arrives and
+// every counter is taken, it replaces the word with the smallest count m and
+// starts at m + 1 with error m. A word's true count is always within
+// [count - error, count], and any word that occurs more than N / capacity times
+// in a stream of N words is guaranteed to be monitored.
+class SpaceSaving {
+public:
+    struct Entry {
+        std::string_view word;
+        long long count;
+        long long error;
+    };
+
+private:
+    std::vector<std::string> words;     // never reallocated, the index keys view into it
+    std::vector<long long> counts;
+    std::vector<long long> errors;
+    std::vector<std::size_t> heapPos;
+    std::vector<std::size_t> heap;      // counter ids, min-heap on count
+    std::unordered_map<std::string_view, std::size_t> index;
+    std::size_t capacity;
+    long long total {0};
+
+    void swapHeap(std::size_t a, std::size_t b) {
+        std::swap(heap[a], heap[b]);
+        heapPos[heap[a]] = a;
+        heapPos[heap[b]] = b;
+    }
+
+    // Counts only ever grow, so a counter can only need to move down
+    void siftDown(std::size_t i) {
+        while (true) {
+            std::size_t smallest {i};
+            std::size_t left {2 * i + 1};
+            std::size_t right {left + 1};
+            if (left < heap.size() && counts[heap[left]] < counts[heap[smallest]])
+                smallest = left;
+            if (right < heap.size() && counts[heap[right]] < counts[heap[smallest]])
+                smallest = right;
+            if (smallest == i)
+                return;
+            swapHeap(i, smallest);
+            i = smallest;
+        }
+    }
+
+public:
+    explicit SpaceSaving(std::size_t capacity) : capacity{capacity > 0 ? capacity : 1} {
+        words.reserve(this->capacity);
+        counts.reserve(this->capacity);
+        errors.reserve(this->capacity);
+        heapPos.reserve(this->capacity);
+        heap.reserve(this->capacity);
+        index.reserve(this->capacity);
+    }
+
+    void add(std::string_view word) {
+        total++;
+        auto iter = index.find(word);
+        if (iter != index.end()) {
+            counts[iter->second]++;
+            siftDown(heapPos[iter->second]);
+            return;
+        }
+
+        if (words.size() < capacity) {
+            std::size_t id {words.size()};
+            words.emplace_back(word);
+            counts.push_back(1);
+            errors.push_back(0);
+            heapPos.push_back(heap.size());
+            heap.push_back(id);
+            index.emplace(words[id], id);
+            // A new count of 1 is never bigger than its parent's, move it up
+            for (std::size_t i {heap.size() - 1}; i > 0 && counts[heap[(i - 1) / 2]] > counts[heap[i]]; i = (i - 1) / 2)
+                swapHeap(i, (i - 1) / 2);
+            return;
+        }
+
+        std::size_t id {heap[0]};
+        index.erase(words[id]);
+        words[id].assign(word.data(), word.size());
+        index.emplace(words[id], id);
+        errors[id] = counts[id];
+        counts[id]++;
+        siftDown(0);
+    }
+
+    // The k words with the highest counts, highest first (ties in word order)
+    std::vector<Entry> top(std::size_t k) const {
+        std::vector<Entry> entries;
+        entries.reserve(words.size());
+        for (std::size_t i {0}; i < words.size(); i++)
+            entries.push_back({words[i], counts[i], errors[i]});
+
+        k = std::min(k, entries.size());
+        auto byCount = [](const Entry& lhs, const Entry& rhs) {
+            return lhs.count != rhs.count ? lhs.count > rhs.count : lhs.word < rhs.word;
+        };
+        std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(k), entries.end(), byCount);
+        entries.resize(k);
+        return entries;
+    }
+
+    // Words seen so far
+    long long streamSize() const { return total; }
+    // Upper bound on the count of any word that is not being monitored
+    long long minCount() const { return words.size() < capacity ? 0 : counts[heap[0]]; }
+};
+
+#endif //CPPNOTES_TOPK_H
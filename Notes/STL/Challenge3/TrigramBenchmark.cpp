@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include "WordIndex.h"
+#include "TrigramIndex.h"
+
+// Wildcard lookups through a TrigramIndex against checking every word of a
+// std::map vocabulary (WordCounts) with globMatch(). The vocabulary is random
+// words of 3 - 15 letters, and the patterns are cut out of words in it, so
+// each kind of pattern has at least one match. Every trigram result is
+// checked against the scan.
+//
+// Usage: TrigramBenchmark [vocabulary size, default 2000000] [patterns per kind, default 20]
+
+void benchmark(const std::string& kind, const std::vector<std::string>& patterns, const WordCounts& vocabulary,
+               const TrigramIndex& trigrams);
+
+int main(int argc, char* argv[]) {
+    std::size_t vocabularySize {argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000};
+    std::size_t patternCount {argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20};
+
+    std::mt19937_64 rng {42};
+    std::uniform_int_distribution<int> length {3, 15};
+    std::uniform_int_distribution<int> letter {0, 25};
+    WordCounts vocabulary;
+    while (vocabulary.size() < vocabularySize) {
+        std::string word(static_cast<std::size_t>(length(rng)), ' ');
+        for (auto& c : word)
+            c = static_cast<char>('a' + letter(rng));
+        vocabulary.emplace(word, 1);
+    }
+    std::vector<std::string> words;
+    for (const auto& pair : vocabulary)
+        words.push_back(pair.first);
+
+    auto start = std::chrono::steady_clock::now();
+    TrigramIndex trigrams {vocabulary};
+    double seconds {std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    std::cout << trigrams.size() << " words, trigram index built in " << std::fixed << std::setprecision(2)
+              << seconds << " s, " << trigrams.memoryUsage() / (1024 * 1024) << " MB\n\n";
+
+    // Cuts a pattern out of a random word
+    auto patterns = [&](const std::function<std::string(const std::string&)>& cut) {
+        std::vector<std::string> result;
+        std::uniform_int_distribution<std::size_t> pick {0, words.size() - 1};
+        while (result.size() < patternCount)
+            result.push_back(cut(words[pick(rng)]));
+        return result;
+    };
+
+    std::cout << std::setw(12) << std::left << "Pattern"
+              << std::setw(10) << std::right << "Matches"
+              << std::setw(12) << std::right << "Candidates"
+              << std::setw(12) << std::right << "Scan us"
+              << std::setw(12) << std::right << "Trigram us"
+              << std::setw(10) << std::right << "Speedup" << std::endl;
+    std::cout << std::string(68, '=') << std::endl;
+
+    benchmark("*abcd*", patterns([](const std::string& word) {
+        std::size_t from {word.size() / 3};
+        return "*" + word.substr(from, std::min<std::size_t>(4, word.size() - from)) + "*";
+    }), vocabulary, trigrams);
+    benchmark("abc*", patterns([](const std::string& word) { return word.substr(0, 3) + "*"; }),
+              vocabulary, trigrams);
+    benchmark("*abc", patterns([](const std::string& word) { return "*" + word.substr(word.size() - 3); }),
+              vocabulary, trigrams);
+    benchmark("ab?de?g", patterns([](const std::string& word) {
+        std::string pattern {word};
+        pattern[pattern.size() / 2] = '?';
+        pattern[pattern.size() - 1] = '?';
+        return pattern;
+    }), vocabulary, trigrams);
+    benchmark("ab*ef", patterns([](const std::string& word) {
+        return word.substr(0, 2) + "*" + word.substr(word.size() - 2);
+    }), vocabulary, trigrams);
+    return 0;
+}
+
+void benchmark(const std::string& kind, const std::vector<std::string>& patterns, const WordCounts& vocabulary,
+               const TrigramIndex& trigrams) {
+    std::size_t matches {0};
+    std::size_t candidates {0};
+    std::size_t mismatches {0};
+    double scanSeconds {0.0};
+    double trigramSeconds {0.0};
+
+    for (const auto& pattern : patterns) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::string_view> scanned;
+        for (const auto& pair : vocabulary)
+            if (globMatch(pattern, pair.first))
+                scanned.push_back(pair.first);
+        auto middle = std::chrono::steady_clock::now();
+        std::vector<std::uint32_t> found {trigrams.match(pattern)};
+        auto end = std::chrono::steady_clock::now();
+
+        scanSeconds += std::chrono::duration<double>(middle - start).count();
+        trigramSeconds += std::chrono::duration<double>(end - middle).count();
+        matches += found.size();
+        candidates += trigrams.candidates(pattern).size();
+
+        bool same {found.size() == scanned.size()};
+        for (std::size_t i {0}; same && i < found.size(); i++)
+            same = trigrams.word(found[i]) == scanned[i];
+        mismatches += !same;
+    }
+
+    auto perPattern = [&patterns](double total) { return total * 1e6 / static_cast<double>(patterns.size()); };
+    std::cout << std::setw(12) << std::left << kind
+              << std::setw(10) << std::right << matches / patterns.size()
+              << std::setw(12) << std::right << candidates / patterns.size()
+              << std::setw(12) << std::right << std::fixed << std::setprecision(1) << perPattern(scanSeconds)
+              << std::setw(12) << std::right << perPattern(trigramSeconds)
+              << std::setw(9) << std::right << std::setprecision(0) << scanSeconds / trigramSeconds << "x\n";
+    if (mismatches > 0)
+        std::cout << mismatches << " trigram results differ from the scan!\n";
+}
@@ -0,0 +1,206 @@
+#ifndef CPPNOTES_TRIGRAMINDEX_H
+#define CPPNOTES_TRIGRAMINDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// Glob match of the whole word: '*' is any run of bytes (including none), '?'
+// any one byte, everything else matches itself. Greedy with one backtrack
+// point, so it is linear unless the pattern has many stars.
+inline bool globMatch(std::string_view pattern, std::string_view word) {
+    std::size_t p {0};
+    std::size_t w {0};
+    std::size_t star {std::string_view::npos};     // last '*' seen in pattern
+    std::size_t resume {0};                         // where word picks up after it
+    while (w < word.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == word[w])) {
+            p++;
+            w++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = w;
+        } else if (star != std::string_view::npos) {
+            p = star + 1;
+            w = ++resume;
+        } else
+            return false;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+// Wildcard lookups ("*oroth*", "Dor?thy", "Em*") over a fixed vocabulary.
+//
+// Every word is padded with a start and an end marker and broken into the
+// overlapping 3 byte pieces (trigrams) of that, and each trigram keeps the
+// sorted list of the words it occurs in. The literal runs of a pattern must
+// turn up in every word that matches, so the words that have all of the
+// pattern's trigrams are a (usually tiny) superset of the answer: those lists
+// are intersected, shortest first, and only the survivors go through
+// globMatch(). A pattern with no trigram at all ("*a*", "??") falls back to
+// checking every word.
+//
+// Words are numbered by their position in the vocabulary it was built from, so
+// with a sorted vocabulary the results come out sorted too.
+class TrigramIndex {
+private:
+    static constexpr char startMarker {'\x01'};
+    static constexpr char endMarker {'\x02'};
+
+    std::vector<char> bytes;
+    std::vector<std::uint64_t> offsets;     // word i is bytes[offsets[i], offsets[i + 1])
+    std::vector<std::uint32_t> keys;        // every trigram, ascending
+    std::vector<std::uint32_t> starts;      // keys[i] lists words[starts[i], starts[i + 1])
+    std::vector<std::uint32_t> words;
+
+    template <typename Word>
+    static std::string_view keyOf(const Word& word) { return word; }
+
+    template <typename Key, typename Value>
+    static std::string_view keyOf(const std::pair<Key, Value>& pair) { return pair.first; }
+
+    static std::uint32_t trigram(const char* p) {
+        return static_cast<std::uint32_t>(static_cast<unsigned char>(p[0])) << 16
+               | static_cast<std::uint32_t>(static_cast<unsigned char>(p[1])) << 8
+               | static_cast<std::uint32_t>(static_cast<unsigned char>(p[2]));
+    }
+
+    // Calls onTrigram for every trigram of every literal run of text
+    template <typename OnTrigram>
+    static void forEachTrigram(std::string_view text, OnTrigram&& onTrigram) {
+        std::size_t run {0};
+        for (std::size_t i {0}; i < text.size(); i++) {
+            if (text[i] == '*' || text[i] == '?')
+                run = 0;
+            else if (++run >= 3)
+                onTrigram(trigram(text.data() + i - 2));
+        }
+    }
+
+    // Padded pattern: anchored ends get the same markers the words have
+    static std::string padPattern(std::string_view pattern) {
+        std::string padded;
+        if (pattern.empty() || pattern.front() != '*')
+            padded += startMarker;
+        padded += pattern;
+        if (pattern.empty() || pattern.back() != '*')
+            padded += endMarker;
+        return padded;
+    }
+
+    // Word list of one trigram, empty if no word has it
+    std::pair<const std::uint32_t*, const std::uint32_t*> listOf(std::uint32_t key) const {
+        auto iter = std::lower_bound(keys.begin(), keys.end(), key);
+        if (iter == keys.end() || *iter != key)
+            return {nullptr, nullptr};
+        auto i = static_cast<std::size_t>(iter - keys.begin());
+        return {words.data() + starts[i], words.data() + starts[i + 1]};
+    }
+
+public:
+    TrigramIndex() = default;
+
+    // words must be unique: a range of strings, or a map such as WordCounts
+    // whose keys are used
+    template <typename Words>
+    explicit TrigramIndex(const Words& vocabulary) {
+        offsets.push_back(0);
+        std::vector<std::uint64_t> pairs;       // trigram << 32 | word
+        std::string padded;
+        for (const auto& w : vocabulary) {
+            std::string_view view {keyOf(w)};
+            auto id = static_cast<std::uint32_t>(size());
+            bytes.insert(bytes.end(), view.begin(), view.end());
+            offsets.push_back(bytes.size());
+
+            padded.assign(1, startMarker);
+            padded += view;
+            padded += endMarker;
+            for (std::size_t i {0}; i + 3 <= padded.size(); i++)
+                pairs.push_back(static_cast<std::uint64_t>(trigram(padded.data() + i)) << 32 | id);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        words.reserve(pairs.size());
+        for (auto pair : pairs) {
+            auto key = static_cast<std::uint32_t>(pair >> 32);
+            if (keys.empty() || keys.back() != key) {
+                keys.push_back(key);
+                starts.push_back(static_cast<std::uint32_t>(words.size()));
+            }
+            words.push_back(static_cast<std::uint32_t>(pair));
+        }
+        starts.push_back(static_cast<std::uint32_t>(words.size()));
+    }
+
+    std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    std::string_view word(std::size_t i) const {
+        return {bytes.data() + offsets[i], static_cast<std::size_t>(offsets[i + 1] - offsets[i])};
+    }
+
+    // Words that have every trigram of pattern, ascending: every match and
+    // maybe a few more. Every word if pattern has no trigram.
+    std::vector<std::uint32_t> candidates(std::string_view pattern) const {
+        std::vector<std::pair<const std::uint32_t*, const std::uint32_t*>> lists;
+        bool missing {false};
+        forEachTrigram(padPattern(pattern), [this, &lists, &missing](std::uint32_t key) {
+            lists.push_back(listOf(key));
+            missing |= lists.back().first == nullptr;
+        });
+
+        std::vector<std::uint32_t> result;
+        if (missing)
+            return result;
+        if (lists.empty()) {
+            result.resize(size());
+            for (std::uint32_t i {0}; i < result.size(); i++)
+                result[i] = i;
+            return result;
+        }
+
+        std::sort(lists.begin(), lists.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second - lhs.first < rhs.second - rhs.first;
+        });
+        result.assign(lists[0].first, lists[0].second);
+        // Each survivor is searched for in the longer list, from where the
+        // last one was found
+        for (std::size_t i {1}; i < lists.size() && !result.empty(); i++) {
+            const std::uint32_t* from {lists[i].first};
+            std::size_t kept {0};
+            for (auto id : result) {
+                from = std::lower_bound(from, lists[i].second, id);
+                if (from == lists[i].second)
+                    break;
+                if (*from == id)
+                    result[kept++] = id;
+            }
+            result.resize(kept);
+        }
+        return result;
+    }
+
+    // Words matching pattern (see globMatch()), ascending
+    std::vector<std::uint32_t> match(std::string_view pattern) const {
+        std::vector<std::uint32_t> result {candidates(pattern)};
+        result.erase(std::remove_if(result.begin(), result.end(), [this, pattern](std::uint32_t id) {
+            return !globMatch(pattern, word(id));
+        }), result.end());
+        return result;
+    }
+
+    // Approximate heap footprint in bytes
+    std::size_t memoryUsage() const {
+        return bytes.capacity() + offsets.capacity() * sizeof(std::uint64_t)
+               + (keys.capacity() + starts.capacity() + words.capacity()) * sizeof(std::uint32_t);
+    }
+};
+
+#endif //CPPNOTES_TRIGRAMINDEX_H
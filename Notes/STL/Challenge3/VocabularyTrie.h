@@ -0,0 +1,213 @@
+#ifndef CPPNOTES_VOCABULARYTRIE_H
+#define CPPNOTES_VOCABULARYTRIE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// Prefix lookups over a fixed, sorted vocabulary.
+//
+// A path compressed (radix) trie stored in flat arrays: a node only exists
+// where words branch or end, so there are at most ~2 nodes per word. All
+// of a node's children sit next to each other in one array, with their first
+// edge bytes in a parallel array that is scanned or binary searched to pick
+// the child. Edge labels are not stored separately, they are read from the
+// vocabulary itself.
+//
+// Because the vocabulary is sorted, the words below any node are one
+// contiguous range of it. So counting the words with a prefix is a walk of
+// |prefix| bytes, and enumerating them is a slice, with no tree walk at all.
+class VocabularyTrie {
+private:
+    struct Node {
+        std::uint32_t wordBegin;    // words below this node are [wordBegin, wordEnd)
+        std::uint32_t wordEnd;
+        std::uint32_t firstChild;
+        std::uint32_t childCount;
+        std::uint32_t depth;        // length of the prefix this node stands for
+    };
+
+    std::vector<char> bytes;
+    std::vector<std::uint64_t> offsets;     // word i is bytes[offsets[i], offsets[i + 1])
+    std::vector<Node> nodes;
+    std::vector<unsigned char> labels;      // first edge byte of nodes[i], parallel to nodes
+
+    // Builds every node below the root. Nodes whose children are still to be
+    // built wait on a stack rather than in recursive calls, so a vocabulary of
+    // very long words that share long prefixes cannot overflow the call stack.
+    // Children are pushed last first, so nodes are laid out in the same
+    // depth first order the recursion used.
+    void buildNodes() {
+        std::vector<std::uint32_t> pending {0};
+        std::vector<Node> children;
+        std::vector<unsigned char> childLabels;
+        while (!pending.empty()) {
+            std::uint32_t parent {pending.back()};
+            pending.pop_back();
+
+            Node node {nodes[parent]};
+            std::uint32_t i {node.wordBegin};
+            // A word that ends exactly here sorts first and has no child
+            if (i < node.wordEnd && word(i).size() == node.depth)
+                i++;
+
+            children.clear();
+            childLabels.clear();
+            while (i < node.wordEnd) {
+                auto label = static_cast<unsigned char>(word(i)[node.depth]);
+                std::uint32_t end {i + 1};
+                while (end < node.wordEnd && static_cast<unsigned char>(word(end)[node.depth]) == label)
+                    end++;
+
+                // The child's edge runs as far as all of its words agree
+                std::string_view first {word(i)};
+                std::string_view last {word(end - 1)};
+                std::size_t depth {static_cast<std::size_t>(node.depth) + 1};
+                while (depth < first.size() && depth < last.size() && first[depth] == last[depth])
+                    depth++;
+
+                children.push_back({i, end, 0, 0, static_cast<std::uint32_t>(depth)});
+                childLabels.push_back(label);
+                i = end;
+            }
+
+            auto firstChild = static_cast<std::uint32_t>(nodes.size());
+            nodes[parent].firstChild = firstChild;
+            nodes[parent].childCount = static_cast<std::uint32_t>(children.size());
+            nodes.insert(nodes.end(), children.begin(), children.end());
+            labels.insert(labels.end(), childLabels.begin(), childLabels.end());
+
+            for (auto child = static_cast<std::uint32_t>(firstChild + children.size()); child > firstChild; child--)
+                pending.push_back(child - 1);
+        }
+    }
+
+    template <typename Word>
+    static std::string_view keyOf(const Word& word) { return word; }
+
+    template <typename Key, typename Value>
+    static std::string_view keyOf(const std::pair<Key, Value>& pair) { return pair.first; }
+
+    // Child of node whose edge starts with label, or 0 (the root is never a child)
+    std::uint32_t child(const Node& node, unsigned char label) const {
+        const unsigned char* first {labels.data() + node.firstChild};
+        const unsigned char* last {first + node.childCount};
+        const unsigned char* found {node.childCount <= 8 ? std::find(first, last, label)
+                                                         : std::lower_bound(first, last, label)};
+        return found != last && *found == label ? static_cast<std::uint32_t>(found - labels.data()) : 0;
+    }
+
+    // Node for the shortest prefix that starts with prefix, or 0 if no word does
+    std::uint32_t locate(std::string_view prefix) const {
+        std::uint32_t current {0};
+        std::size_t matched {0};
+        while (matched < prefix.size()) {
+            std::uint32_t next {child(nodes[current], static_cast<unsigned char>(prefix[matched]))};
+            if (next == 0)
+                return 0;
+
+            // Check the rest of the edge (or as much of it as the prefix covers)
+            std::string_view edge {word(nodes[next].wordBegin).substr(matched, nodes[next].depth - matched)};
+            std::size_t length {std::min(edge.size(), prefix.size() - matched)};
+            if (edge.compare(0, length, prefix.substr(matched, length)) != 0)
+                return 0;
+            current = next;
+            matched += length;
+        }
+        return current;
+    }
+
+public:
+    VocabularyTrie() = default;
+
+    // words must be sorted and unique: a range of strings, or a map such as
+    // WordCounts whose keys are used
+    template <typename Words>
+    explicit VocabularyTrie(const Words& words) {
+        offsets.push_back(0);
+        for (const auto& w : words) {
+            std::string_view view {keyOf(w)};
+            bytes.insert(bytes.end(), view.begin(), view.end());
+            offsets.push_back(bytes.size());
+        }
+        nodes.push_back({0, static_cast<std::uint32_t>(size()), 0, 0, 0});
+        labels.push_back(0);
+        buildNodes();
+    }
+
+    std::size_t size() const { return offsets.size() - 1; }
+
+    std::string_view word(std::size_t i) const {
+        return {bytes.data() + offsets[i], static_cast<std::size_t>(offsets[i + 1] - offsets[i])};
+    }
+
+    // Words starting with prefix are word(first) .. word(second - 1)
+    std::pair<std::size_t, std::size_t> prefixRange(std::string_view prefix) const {
+        if (prefix.empty())
+            return {0, size()};
+        std::uint32_t node {locate(prefix)};
+        return node == 0 ? std::pair<std::size_t, std::size_t>{0, 0}
+                         : std::pair<std::size_t, std::size_t>{nodes[node].wordBegin, nodes[node].wordEnd};
+    }
+
+    std::size_t countPrefix(std::string_view prefix) const {
+        auto range = prefixRange(prefix);
+        return range.second - range.first;
+    }
+
+    // Up to limit words starting with prefix, in order
+    std::vector<std::string_view> complete(std::string_view prefix, std::size_t limit) const {
+        auto range = prefixRange(prefix);
+        std::vector<std::string_view> words;
+        for (std::size_t i {range.first}; i < range.second && words.size() < limit; i++)
+            words.push_back(word(i));
+        return words;
+    }
+
+    // Longest prefix shared by every word that starts with prefix: how far an
+    // autocomplete can safely extend what was typed. Empty if nothing matches.
+    std::string_view longestCommonPrefix(std::string_view prefix) const {
+        std::uint32_t node {prefix.empty() ? 0 : locate(prefix)};
+        if (node == 0 && !prefix.empty())
+            return {};
+        if (nodes[node].wordBegin == nodes[node].wordEnd)
+            return {};
+        // The root is the one node whose edge is not compressed: if every word
+        // goes on through the same single child, that child is how far they
+        // all agree
+        if (node == 0 && nodes[0].childCount == 1 && word(nodes[0].wordBegin).size() > 0)
+            node = nodes[0].firstChild;
+        return word(nodes[node].wordBegin).substr(0, nodes[node].depth);
+    }
+
+    // Longest vocabulary word that is a prefix of text, empty if there is none
+    std::string_view longestMatch(std::string_view text) const {
+        std::string_view best;
+        std::uint32_t current {0};
+        while (true) {
+            const Node& node {nodes[current]};
+            if (node.wordBegin < node.wordEnd && word(node.wordBegin).size() == node.depth)
+                best = word(node.wordBegin);
+            if (node.depth >= text.size())
+                return best;
+
+            std::uint32_t next {child(node, static_cast<unsigned char>(text[node.depth]))};
+            if (next == 0 || nodes[next].depth > text.size()
+                || word(nodes[next].wordBegin).compare(0, nodes[next].depth, text.substr(0, nodes[next].depth)) != 0)
+                return best;
+            current = next;
+        }
+    }
+
+    // Approximate heap footprint in bytes
+    std::size_t memoryUsage() const {
+        return bytes.capacity() + offsets.capacity() * sizeof(std::uint64_t)
+               + nodes.capacity() * sizeof(Node) + labels.capacity();
+    }
+};
+
+#endif //CPPNOTES_VOCABULARYTRIE_H
@@ -0,0 +1,106 @@
+#ifndef CPPNOTES_WORDCLASSIFIER_H
+#define CPPNOTES_WORDCLASSIFIER_H
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPPNOTES_X86 1
+#include <immintrin.h>
+#endif
+
+// Bit i of each mask describes byte i of a 64 byte block
+struct BlockMasks {
+    std::uint64_t space;    // ' ', '\t', '\n', '\v', '\f' or '\r'
+    std::uint64_t punct;    // '.', ',', ';' or ':'
+    std::uint64_t newline;  // '\n'
+};
+
+// Fills masks for the 64 bytes at block
+using ClassifyKernel = void (*)(const char* block, BlockMasks& masks);
+
+// The byte classes are picked so they need no lookup table:
+//   '\t'..'\r' are 9..13, so one unsigned (c - 9) <= 4 test covers them
+//   ',' (44) and '.' (46) only differ in bit 1, ':' (58) and ';' (59) in bit 0
+
+inline void classifyScalar(const char* block, BlockMasks& masks) {
+    std::uint64_t space {0};
+    std::uint64_t punct {0};
+    std::uint64_t newline {0};
+    for (int i {0}; i < 64; i++) {
+        auto c = static_cast<unsigned char>(block[i]);
+        space |= static_cast<std::uint64_t>((c == ' ') | (static_cast<unsigned char>(c - 9) <= 4)) << i;
+        punct |= static_cast<std::uint64_t>(((c & 0xfd) == ',') | ((c & 0xfe) == ':')) << i;
+        newline |= static_cast<std::uint64_t>(c == '\n') << i;
+    }
+    masks = {space, punct, newline};
+}
+
+#ifdef CPPNOTES_X86
+
+__attribute__((target("sse2")))
+inline void classifySse2(const char* block, BlockMasks& masks) {
+    const __m128i blank {_mm_set1_epi8(' ')};
+    const __m128i tab {_mm_set1_epi8('\t')};
+    const __m128i four {_mm_set1_epi8(4)};
+    const __m128i newline {_mm_set1_epi8('\n')};
+    const __m128i comma {_mm_set1_epi8(',')};
+    const __m128i colon {_mm_set1_epi8(':')};
+    const __m128i notBit1 {_mm_set1_epi8(static_cast<char>(0xfd))};
+    const __m128i notBit0 {_mm_set1_epi8(static_cast<char>(0xfe))};
+    masks = {0, 0, 0};
+
+    for (int i {0}; i < 4; i++) {
+        __m128i bytes {_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i))};
+        __m128i control {_mm_sub_epi8(bytes, tab)};
+        control = _mm_cmpeq_epi8(_mm_min_epu8(control, four), control);
+        __m128i space {_mm_or_si128(_mm_cmpeq_epi8(bytes, blank), control)};
+        __m128i punct {_mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(bytes, notBit1), comma),
+                                    _mm_cmpeq_epi8(_mm_and_si128(bytes, notBit0), colon))};
+
+        masks.space |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(space))) << (16 * i);
+        masks.punct |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(punct))) << (16 * i);
+        masks.newline |= static_cast<std::uint64_t>(
+                static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)))) << (16 * i);
+    }
+}
+
+__attribute__((target("avx2")))
+inline void classifyAvx2(const char* block, BlockMasks& masks) {
+    const __m256i blank {_mm256_set1_epi8(' ')};
+    const __m256i tab {_mm256_set1_epi8('\t')};
+    const __m256i four {_mm256_set1_epi8(4)};
+    const __m256i newline {_mm256_set1_epi8('\n')};
+    const __m256i comma {_mm256_set1_epi8(',')};
+    const __m256i colon {_mm256_set1_epi8(':')};
+    const __m256i notBit1 {_mm256_set1_epi8(static_cast<char>(0xfd))};
+    const __m256i notBit0 {_mm256_set1_epi8(static_cast<char>(0xfe))};
+    masks = {0, 0, 0};
+
+    for (int i {0}; i < 2; i++) {
+        __m256i bytes {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i))};
+        __m256i control {_mm256_sub_epi8(bytes, tab)};
+        control = _mm256_cmpeq_epi8(_mm256_min_epu8(control, four), control);
+        __m256i space {_mm256_or_si256(_mm256_cmpeq_epi8(bytes, blank), control)};
+        __m256i punct {_mm256_or_si256(_mm256_cmpeq_epi8(_mm256_and_si256(bytes, notBit1), comma),
+                                       _mm256_cmpeq_epi8(_mm256_and_si256(bytes, notBit0), colon))};
+
+        masks.space |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(space))) << (32 * i);
+        masks.punct |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(punct))) << (32 * i);
+        masks.newline |= static_cast<std::uint64_t>(
+                static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)))) << (32 * i);
+    }
+}
+
+#endif
+
+// Fastest kernel the running CPU supports, checked once
+inline ClassifyKernel bestClassifyKernel() {
+#ifdef CPPNOTES_X86
+    static const ClassifyKernel best {__builtin_cpu_supports("avx2") ? classifyAvx2 : classifySse2};
+    return best;
+#else
+    return classifyScalar;
+#endif
+}
+
+#endif //CPPNOTES_WORDCLASSIFIER_H
@@ -0,0 +1,164 @@
+#ifndef CPPNOTES_WORDDICTIONARY_H
+#define CPPNOTES_WORDDICTIONARY_H
+
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "WordHash.h"
+#include "Tokenizer.h"
+#include "PostingList.h"
+
+// Interns words: each distinct word is stored once, back to back in one byte
+// arena, and gets a dense ID (0, 1, 2, ... in order of first appearance).
+// Anything keyed by word can then be a plain vector indexed by ID, or a table
+// of 4-byte IDs, instead of a tree of separately allocated std::strings.
+//
+// The ID lookup table is open addressing with 8-byte slots (ID + 1 and 32 bits
+// of the hash); the full hashes are kept per ID so growing never rehashes a
+// string.
+class WordDictionary {
+private:
+    struct Slot {
+        std::uint32_t id;       // ID + 1, 0 marks an empty slot
+        std::uint32_t tag;      // high half of the hash
+    };
+
+    std::vector<char> bytes;
+    std::vector<std::uint64_t> offsets {0};     // word i is bytes[offsets[i], offsets[i + 1])
+    std::vector<std::uint64_t> hashes;
+    std::vector<Slot> slots;
+    std::size_t mask {0};
+
+    static std::uint32_t tagOf(std::uint64_t hash) { return static_cast<std::uint32_t>(hash >> 32); }
+
+    void grow() {
+        slots.assign(slots.empty() ? 1024 : slots.size() * 2, Slot{0, 0});
+        mask = slots.size() - 1;
+        for (std::uint32_t id {0}; id < size(); id++) {
+            std::size_t i {hashes[id] & mask};
+            while (slots[i].id != 0)
+                i = (i + 1) & mask;
+            slots[i] = {id + 1, tagOf(hashes[id])};
+        }
+    }
+
+    // Slot holding word, or the empty slot where it would go
+    std::size_t probe(std::string_view word, std::uint64_t hash) const {
+        std::size_t i {hash & mask};
+        while (slots[i].id != 0) {
+            if (slots[i].tag == tagOf(hash) && this->word(slots[i].id - 1) == word)
+                return i;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+public:
+    static constexpr std::uint32_t none {0xffffffff};
+
+    WordDictionary() { grow(); }
+
+    // ID of word, adding it if it is new
+    std::uint32_t intern(std::string_view word) {
+        std::uint64_t hash {hashWord(word)};
+        std::size_t i {probe(word, hash)};
+        if (slots[i].id != 0)
+            return slots[i].id - 1;
+
+        auto id = static_cast<std::uint32_t>(size());
+        bytes.insert(bytes.end(), word.begin(), word.end());
+        offsets.push_back(bytes.size());
+        hashes.push_back(hash);
+        slots[i] = {id + 1, tagOf(hash)};
+        // Keep the load factor under 70% so probe runs stay short
+        if ((size() + 1) * 10 > slots.size() * 7)
+            grow();
+        return id;
+    }
+
+    // ID of word, none if it was never interned
+    std::uint32_t find(std::string_view word) const {
+        std::size_t i {probe(word, hashWord(word))};
+        return slots[i].id != 0 ? slots[i].id - 1 : none;
+    }
+
+    // Stays valid until the next intern()
+    std::string_view word(std::uint32_t id) const {
+        return {bytes.data() + offsets[id], static_cast<std::size_t>(offsets[id + 1] - offsets[id])};
+    }
+
+    std::size_t size() const { return hashes.size(); }
+
+    // Every ID, ordered by its word the way std::map orders its keys
+    std::vector<std::uint32_t> sortedIds() const {
+        std::vector<std::uint32_t> ids(size());
+        for (std::uint32_t id {0}; id < ids.size(); id++)
+            ids[id] = id;
+        std::sort(ids.begin(), ids.end(), [this](std::uint32_t lhs, std::uint32_t rhs) {
+            return word(lhs) < word(rhs);
+        });
+        return ids;
+    }
+
+    // Approximate heap footprint in bytes
+    std::size_t memoryUsage() const {
+        return bytes.capacity() + offsets.capacity() * sizeof(std::uint64_t)
+               + hashes.capacity() * sizeof(std::uint64_t) + slots.capacity() * sizeof(Slot);
+    }
+};
+
+// Part 1 counts and part 2 line lists keyed by interned word ID: both are
+// plain vectors indexed by ID, so adding a word is one dictionary lookup and
+// two array updates, and the only per-word allocation is its PostingList.
+struct InternedIndex {
+    WordDictionary words;
+    std::vector<int> counts;
+    std::vector<PostingList> lines;
+
+    void add(std::string_view word, int line) {
+        std::uint32_t id {words.intern(word)};
+        if (id == counts.size()) {
+            counts.push_back(0);
+            lines.emplace_back();
+        }
+        counts[id]++;
+        lines[id].append(line);
+    }
+
+    void build(std::string_view text, int firstLine = 1) {
+        forEachWord(text, [this](std::string_view word, int line) {
+            add(word, line);
+        }, firstLine);
+    }
+
+    // (word, count) and (word, lines) in word order, ready for the reports.
+    // The views point into the index.
+    std::vector<std::pair<std::string_view, int>> sortedCounts() const {
+        std::vector<std::pair<std::string_view, int>> sorted;
+        sorted.reserve(words.size());
+        for (auto id : words.sortedIds())
+            sorted.emplace_back(words.word(id), counts[id]);
+        return sorted;
+    }
+
+    std::vector<std::pair<std::string_view, PostingView>> sortedLines() const {
+        std::vector<std::pair<std::string_view, PostingView>> sorted;
+        sorted.reserve(words.size());
+        for (auto id : words.sortedIds())
+            sorted.emplace_back(words.word(id), lines[id].view());
+        return sorted;
+    }
+
+    std::size_t memoryUsage() const {
+        std::size_t bytes {words.memoryUsage() + counts.capacity() * sizeof(int)
+                           + lines.capacity() * sizeof(PostingList)};
+        for (const auto& list : lines)
+            bytes += list.encoded().capacity();
+        return bytes;
+    }
+};
+
+#endif //CPPNOTES_WORDDICTIONARY_H
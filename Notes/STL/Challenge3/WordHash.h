@@ -0,0 +1,44 @@
+#ifndef CPPNOTES_WORDHASH_H
+#define CPPNOTES_WORDHASH_H
+
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+// 64-bit multiply/xor-shift mix (the murmur3 finalizer)
+constexpr std::uint64_t mixHash(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Fast hash for short words: eats the word 8 bytes at a time and mixes once at
+// the end. Good enough for hash tables and sketches, not for anything security
+// related.
+inline std::uint64_t hashWord(std::string_view word) {
+    const char* p {word.data()};
+    std::size_t left {word.size()};
+    std::uint64_t h {0x9e3779b97f4a7c15ULL ^ (word.size() * 0x100000001b3ULL)};
+
+    while (left >= 8) {
+        std::uint64_t block;
+        std::memcpy(&block, p, 8);
+        h = (h ^ block) * 0x2127599bf4325c37ULL;
+        h ^= h >> 29;
+        p += 8;
+        left -= 8;
+    }
+    if (left > 0) {
+        std::uint64_t block {0};
+        std::memcpy(&block, p, left);
+        h = (h ^ block) * 0x2127599bf4325c37ULL;
+        h ^= h >> 29;
+    }
+    return mixHash(h);
+}
+
+#endif //CPPNOTES_WORDHASH_H
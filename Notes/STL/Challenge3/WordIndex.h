@@ -0,0 +1,39 @@
+#ifndef CPPNOTES_WORDINDEX_H
+#define CPPNOTES_WORDINDEX_H
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <set>
+#include <functional>
+#include "PostingList.h"
+
+// std::less<> makes the maps transparent, so find()/lower_bound() accept a
+// std::string_view and no std::string has to be built just to look a word up.
+using WordCounts = std::map<std::string, int, std::less<>>;
+using WordLines = std::map<std::string, std::set<int>, std::less<>>;
+// WordLines with the line sets stored as compressed PostingLists
+using WordPostings = std::map<std::string, PostingList, std::less<>>;
+
+// Finds or inserts word, only allocating the key when the word is new
+template <typename Map>
+typename Map::mapped_type& wordEntry(Map& words, std::string_view word) {
+    auto iter = words.lower_bound(word);
+    if (iter == words.end() || iter->first != word)
+        iter = words.emplace_hint(iter, std::string{word}, typename Map::mapped_type{});
+    return iter->second;
+}
+
+inline void addWord(WordCounts& words, std::string_view word) {
+    wordEntry(words, word)++;
+}
+
+inline void addWord(WordLines& words, std::string_view word, int line) {
+    wordEntry(words, word).insert(line);
+}
+
+inline void addWord(WordPostings& words, std::string_view word, int line) {
+    wordEntry(words, word).append(line);
+}
+
+#endif //CPPNOTES_WORDINDEX_H
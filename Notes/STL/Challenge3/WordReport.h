@@ -0,0 +1,37 @@
+#ifndef CPPNOTES_WORDREPORT_H
+#define CPPNOTES_WORDREPORT_H
+
+#include <iostream>
+#include <iomanip>
+
+// The part 1 and part 2 report layouts, shared by every displayWords()
+// overload and the benchmarks. Pairs/Map is anything iterable whose elements
+// have a .first word and a .second count or range of line numbers.
+
+template <typename Pairs>
+void displayCounts(const Pairs& words, std::ostream& os = std::cout) {
+    os << std::setw(12) << std::left << "\nWord"
+       << std::setw(7) << std::right << "Count" << std::endl;
+    os << "===========================" << std::endl;
+
+    for (const auto& pair : words)
+        os << std::setw(12) << std::left << pair.first
+           << std::setw(7) << std::right << pair.second << "\n";
+}
+
+template <typename Map>
+void displayLines(const Map& words, std::ostream& os = std::cout) {
+    os << std::setw(12) << std::left << "\nWord"
+       << "Line Occurrences" << std::endl;
+    os << "======================================================" << std::endl;
+
+    for (const auto& pair : words) {
+        os << std::setw(12) << std::left << pair.first
+           << std::left << "[ ";
+        for (const auto& i : pair.second)
+            os << i << " ";
+        os << "]\n";
+    }
+}
+
+#endif //CPPNOTES_WORDREPORT_H
@@ -0,0 +1,136 @@
+#ifndef CPPNOTES_WORDTABLE_H
+#define CPPNOTES_WORDTABLE_H
+
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include "WordHash.h"
+
+// Open addressing (linear probing) word -> count table.
+//
+// Every slot is 32 bytes and keeps the full hash next to the key, so a probe
+// only touches the key bytes when the hashes already match, and growing never
+// rehashes a string. Words of up to 16 bytes (nearly all of them in English
+// text) live inline in the slot; longer ones go into a shared byte arena.
+// Nothing is kept in order: sorted() sorts the distinct words once at the end.
+class WordTable {
+private:
+    static constexpr std::size_t inlineSize {16};
+    static constexpr std::uint32_t vacant {~std::uint32_t{0}};
+
+    struct Slot {
+        std::uint64_t hash;
+        std::int32_t count;
+        std::uint32_t length;   // vacant marks an empty slot, so any count can be stored
+        union {
+            char bytes[inlineSize];
+            std::uint64_t offset;   // into longWords when length > inlineSize
+        } key;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<char> longWords;
+    std::size_t used {0};
+    std::size_t mask {0};
+
+    std::string_view keyOf(const Slot& slot) const {
+        if (slot.length <= inlineSize)
+            return {slot.key.bytes, slot.length};
+        return {longWords.data() + slot.key.offset, slot.length};
+    }
+
+    void grow() {
+        std::vector<Slot> old {std::move(slots)};
+        slots.assign(old.empty() ? 1024 : old.size() * 2, Slot{0, 0, vacant, {}});
+        mask = slots.size() - 1;
+
+        for (const auto& slot : old) {
+            if (slot.length == vacant)
+                continue;
+            std::size_t i {slot.hash & mask};
+            while (slots[i].length != vacant)
+                i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+
+public:
+    WordTable() { grow(); }
+
+    // Adds n to the count of word, inserting it if it is new. A word added
+    // with n = 0 is still in the table, with a count of 0.
+    void add(std::string_view word, int n = 1) {
+        // Keep the load factor under 70% so probe runs stay short
+        if ((used + 1) * 10 > slots.size() * 7)
+            grow();
+
+        std::uint64_t hash {hashWord(word)};
+        std::size_t i {hash & mask};
+        while (slots[i].length != vacant) {
+            if (slots[i].hash == hash && slots[i].length == word.size() && keyOf(slots[i]) == word) {
+                slots[i].count += n;
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+
+        Slot& slot {slots[i]};
+        slot.hash = hash;
+        slot.count = n;
+        slot.length = static_cast<std::uint32_t>(word.size());
+        if (word.size() <= inlineSize)
+            std::memcpy(slot.key.bytes, word.data(), word.size());
+        else {
+            slot.key.offset = longWords.size();
+            longWords.insert(longWords.end(), word.begin(), word.end());
+        }
+        used++;
+    }
+
+    // Count of word, 0 if it was never added
+    int count(std::string_view word) const {
+        std::uint64_t hash {hashWord(word)};
+        std::size_t i {hash & mask};
+        while (slots[i].length != vacant) {
+            if (slots[i].hash == hash && slots[i].length == word.size() && keyOf(slots[i]) == word)
+                return slots[i].count;
+            i = (i + 1) & mask;
+        }
+        return 0;
+    }
+
+    std::size_t size() const { return used; }
+
+    // Calls f(word, count) for every distinct word, in no particular order
+    template <typename F>
+    void forEach(F&& f) const {
+        for (const auto& slot : slots)
+            if (slot.length != vacant)
+                f(keyOf(slot), slot.count);
+    }
+
+    // The distinct words in ascending order, the same order std::map keeps.
+    // The views point into the table and stay valid until the next add().
+    std::vector<std::pair<std::string_view, int>> sorted() const {
+        std::vector<std::pair<std::string_view, int>> words;
+        words.reserve(used);
+        forEach([&words](std::string_view word, int count) {
+            words.emplace_back(word, count);
+        });
+        std::sort(words.begin(), words.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        return words;
+    }
+
+    // Approximate heap footprint in bytes
+    std::size_t memoryUsage() const {
+        return slots.capacity() * sizeof(Slot) + longWords.capacity();
+    }
+};
+
+#endif //CPPNOTES_WORDTABLE_H
@@ -0,0 +1,85 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <cstdlib>
+#include "MappedFile.h"
+#include "Tokenizer.h"
+#include "WordIndex.h"
+#include "WordTable.h"
+#include "CorpusGenerator.h"
+
+// Compares Challenge3's std::map<std::string, int> word counts against the
+// open addressing WordTable, both fed by the same mmap tokenizer.
+//
+// Usage: WordTableBenchmark [words.txt] [synthetic size in MB, default 1024]
+
+double secondsSince(std::chrono::steady_clock::time_point start);
+void benchmark(const std::string& name, std::string_view text);
+
+int main(int argc, char* argv[]) {
+    std::string path {argc > 1 ? argv[1] : "../Notes/Challenge3/words.txt"};
+    std::size_t megabytes {argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024};
+
+    std::cout << std::setw(16) << std::left << "Corpus"
+              << std::setw(10) << std::left << "Backend"
+              << std::setw(12) << std::right << "Words"
+              << std::setw(12) << std::right << "Seconds"
+              << std::setw(12) << std::right << "MB/s" << std::endl;
+    std::cout << std::string(62, '=') << std::endl;
+
+    MappedFile inFile {path};
+    if (inFile)
+        benchmark("words.txt", inFile.view());
+    else
+        std::cerr << "\nError opening input file!" << std::endl;
+
+    std::string corpus {generateCorpus(42, 100000, megabytes * 1024 * 1024)};
+    benchmark("synthetic " + std::to_string(megabytes) + "MB", corpus);
+    return 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void benchmark(const std::string& name, std::string_view text) {
+    // Small inputs are repeated so the timings are measurable
+    int rounds {text.size() < (1 << 20) ? 1000 : 1};
+    double megabytes {static_cast<double>(text.size()) * rounds / (1024 * 1024)};
+    std::size_t mapWords {0};
+    std::size_t tableWords {0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i {0}; i < rounds; i++) {
+        WordCounts words;
+        forEachWord(text, [&words](std::string_view word, int) {
+            addWord(words, word);
+        });
+        mapWords = words.size();
+    }
+    double mapSeconds {secondsSince(start)};
+
+    start = std::chrono::steady_clock::now();
+    for (int i {0}; i < rounds; i++) {
+        WordTable words;
+        forEachWord(text, [&words](std::string_view word, int) {
+            words.add(word);
+        });
+        // The sort is part of the cost, std::map pays for its order as it goes
+        tableWords = words.sorted().size();
+    }
+    double tableSeconds {secondsSince(start)};
+
+    std::cout << std::setw(16) << std::left << name
+              << std::setw(10) << std::left << "map"
+              << std::setw(12) << std::right << mapWords
+              << std::setw(12) << std::right << std::fixed << std::setprecision(3) << mapSeconds
+              << std::setw(12) << std::right << std::setprecision(1) << megabytes / mapSeconds << "\n";
+    std::cout << std::setw(16) << std::left << name
+              << std::setw(10) << std::left << "table"
+              << std::setw(12) << std::right << tableWords
+              << std::setw(12) << std::right << std::setprecision(3) << tableSeconds
+              << std::setw(12) << std::right << std::setprecision(1) << megabytes / tableSeconds << "\n";
+}